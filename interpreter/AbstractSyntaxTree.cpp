@@ -15,5 +15,4 @@
 
 #include "AbstractSyntaxTree.h"
 
-CONCRETE_ACCEPT_METHOD_IMPL(BinaryExpression)
-CONCRETE_ACCEPT_METHOD_IMPL(NumberLiteral)
+AST_NODE_LIST(CONCRETE_ACCEPT_METHOD_IMPL)
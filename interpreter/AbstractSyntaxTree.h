@@ -17,57 +17,157 @@
 #define ABSTRACT_SYNTAX_TREE_H
 
 #include "Token.h"
+#include "Trace.h"
 #include "VisitorPattern.h"
-#include <iostream>
-#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
 #include <vector>
 
+#define AST_NODE_KIND(classname) classname,
+
+// Concrete class of a node, for dispatch without virtual calls.
+enum class NodeKind : uint8_t { AST_NODE_LIST(AST_NODE_KIND) };
+
+#undef AST_NODE_KIND
+
+// Operation of an expression node, decided when the node is built.
+enum class Operator : uint8_t { None,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate };
+
+// Nodes and their child lists live in a memory resource, normally the
+// parser's arena: a tree is freed all at once by releasing the arena,
+// and node destructors never run.
 class AbstractNode {
 public:
     ABSTRACT_ACCEPT_METHOD_DECL
 
-    AbstractNode(std::shared_ptr<Token> token)
-        : token(token)
+    AbstractNode(NodeKind kind, Operator op, const Token &token,
+        std::pmr::memory_resource *resource)
+        : kind(kind)
+        , op(op)
+        , token(token)
+        , children(resource)
     {
-        std::cout << ".. Creating AST node: " << token->text << std::endl;
+        TRACE_DEBUG(CreateNode, token.type, token.offset);
     }
 
-    virtual ~AbstractNode()
-    {
-        std::cout << ".. Deleting AST node: " << token->text << std::endl;
-    }
+    virtual ~AbstractNode() {}
 
-    void addChild(std::shared_ptr<AbstractNode> child)
+    void addChild(AbstractNode *child)
     {
         children.push_back(child);
     }
 
-    std::shared_ptr<Token> token;
-    std::vector<std::shared_ptr<AbstractNode>> children;
+    NodeKind kind;
+    Operator op;
+    Token token;
+    std::pmr::vector<AbstractNode *> children;
 };
 
+// Create a node in a memory resource.
+template <class Node>
+Node *newNode(std::pmr::memory_resource *resource, const Token &token)
+{
+    void *p = resource->allocate(sizeof(Node), alignof(Node));
+    return new (p) Node(token, resource);
+}
+
 class BinaryExpression : public AbstractNode {
 public:
     CONCRETE_ACCEPT_METHOD_DECL
 
-    BinaryExpression(std::shared_ptr<Token> token)
-        : AbstractNode(token)
+    BinaryExpression(const Token &token, std::pmr::memory_resource *resource)
+        : AbstractNode(NodeKind::BinaryExpression, binaryOperator(token.type),
+              token, resource)
+    {
+        children.reserve(2);
+    }
+
+    static Operator binaryOperator(int type)
     {
+        switch (type) {
+        case Token::Plus:
+            return Operator::Add;
+        case Token::Minus:
+            return Operator::Subtract;
+        case Token::Star:
+            return Operator::Multiply;
+        case Token::Slash:
+            return Operator::Divide;
+        default:
+            return Operator::None;
+        }
     }
 
     ~BinaryExpression() {}
 };
 
+class UnaryExpression : public AbstractNode {
+public:
+    CONCRETE_ACCEPT_METHOD_DECL
+
+    UnaryExpression(const Token &token, std::pmr::memory_resource *resource)
+        : AbstractNode(NodeKind::UnaryExpression,
+              token.type == Token::Minus ? Operator::Negate : Operator::None,
+              token, resource)
+    {
+        children.reserve(1);
+    }
+
+    ~UnaryExpression() {}
+};
+
 class NumberLiteral : public AbstractNode {
 public:
     CONCRETE_ACCEPT_METHOD_DECL
 
-    NumberLiteral(std::shared_ptr<Token> token)
-        : AbstractNode(token)
+    NumberLiteral(const Token &token, std::pmr::memory_resource *resource)
+        : AbstractNode(NodeKind::NumberLiteral, Operator::None, token, resource)
     {
     }
 
     ~NumberLiteral() {}
 };
 
+// A variable, named by its Identifier token; evaluators that take no
+// variable values report it as unknown.
+class Variable : public AbstractNode {
+public:
+    CONCRETE_ACCEPT_METHOD_DECL
+
+    Variable(const Token &token, std::pmr::memory_resource *resource)
+        : AbstractNode(NodeKind::Variable, Operator::None, token, resource)
+    {
+    }
+
+    ~Variable() {}
+
+    std::string_view name; // copied into the node's memory resource
+};
+
+// A chain of '+' and '-' flattened into one node (see SumFlattening.h):
+// the literal terms with their signs applied, and the other terms as
+// children, each with its sign.
+class SumExpression : public AbstractNode {
+public:
+    CONCRETE_ACCEPT_METHOD_DECL
+
+    SumExpression(const Token &token, std::pmr::memory_resource *resource)
+        : AbstractNode(NodeKind::SumExpression, Operator::Add, token, resource)
+        , terms(resource)
+        , signs(resource)
+    {
+    }
+
+    ~SumExpression() {}
+
+    std::pmr::vector<double> terms; // signed values of literal terms
+    std::pmr::vector<double> signs; // 1 or -1 for each child
+};
+
 #endif /* ABSTRACT_SYNTAX_TREE_H */
@@ -0,0 +1,305 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Bytecode.h"
+#include "AbstractSyntaxTree.h"
+#include "FlatTree.h"
+#include "TreeWalker.h"
+#include <math.h>
+#include <functional>
+
+Result<Program *> Compiler::tryCompile(AbstractNode *root)
+{
+    error = Error{ Ok, 0 };
+    program->clear();
+    root->accept(this);
+    program->emit(Halt);
+    if (error.code != Ok)
+        return error;
+    return program;
+}
+
+Result<Program *> Compiler::tryCompile(FlatTree *tree)
+{
+    error = Error{ Ok, 0 };
+    program->clear();
+    tree->accept(this);
+    program->emit(Halt);
+    if (error.code != Ok)
+        return error;
+    return program;
+}
+
+void Compiler::fail(ErrorCode code, size_t offset)
+{
+    if (error.code == Ok)
+        error = Error{ code, offset };
+}
+
+// Each node is stepped before, between and after its children, and
+// emits its instructions at those points.
+void Compiler::compile(AbstractNode *root)
+{
+    walkTree(root, [this](AbstractNode *node, size_t done) {
+        switch (node->kind) {
+        case NodeKind::NumberLiteral:
+            program->emitPush(node->token.number());
+            return;
+        case NodeKind::UnaryExpression:
+            if (done == 0)
+                return;
+            if (node->op == Operator::Negate)
+                program->emit(Neg);
+            else
+                fail(UndefinedOperation, node->token.offset);
+            return;
+        case NodeKind::BinaryExpression:
+            if (done == 2)
+                compileBinary(node);
+            return;
+        case NodeKind::SumExpression:
+            compileSum(static_cast<SumExpression *>(node), done);
+            return;
+        case NodeKind::Variable:
+            compileVariable(node);
+            return;
+        }
+    });
+}
+
+void Compiler::compileBinary(AbstractNode *binexp)
+{
+    switch (binexp->op) {
+    case Operator::Add:
+        program->emit(Add);
+        break;
+    case Operator::Subtract:
+        program->emit(Sub);
+        break;
+    case Operator::Multiply:
+        program->emit(Mul);
+        break;
+    case Operator::Divide:
+        program->emit(Div);
+        break;
+    default:
+        fail(UndefinedOperation, binexp->token.offset);
+    }
+}
+
+// The terms of a sum are added one after the other: the constant terms
+// before the first child, then each child once it is compiled.
+void Compiler::compileSum(SumExpression *sum, size_t done)
+{
+    if (done == 0) {
+        for (size_t i = 0; i < sum->terms.size(); ++i) {
+            program->emitPush(sum->terms[i]);
+            if (i > 0)
+                program->emit(Add);
+        }
+    } else {
+        bool first = sum->terms.empty() && done == 1;
+        if (sum->signs[done - 1] < 0)
+            program->emit(first ? Neg : Sub);
+        else if (!first)
+            program->emit(Add);
+    }
+    if (done == sum->children.size() && sum->terms.empty() && done == 0)
+        program->emitPush(0);
+}
+
+void Compiler::compileVariable(AbstractNode *variable)
+{
+    std::string_view name = static_cast<Variable *>(variable)->name;
+    int slot = program->slot(name);
+    if (slot < 0) {
+        slot = (int)program->variables.size();
+        program->variables.push_back(Program::Slot{ std::string(name), variable->token.offset });
+    }
+    program->emitLoad(slot);
+}
+
+void Compiler::visit(BinaryExpression *binexp)
+{
+    compile(binexp);
+}
+
+void Compiler::visit(UnaryExpression *unexp)
+{
+    compile(unexp);
+}
+
+void Compiler::visit(NumberLiteral *number)
+{
+    program->emitPush(number->token.number());
+}
+
+void Compiler::visit(SumExpression *sum)
+{
+    compile(sum);
+}
+
+void Compiler::visit(Variable *variable)
+{
+    compileVariable(variable);
+}
+
+// A flat tree is already in post-order: one instruction per node.
+void Compiler::visit(FlatTree *tree)
+{
+    if (tree->nodes.empty())
+        return fail(NumberExpected, 0);
+    for (const FlatNode &node : tree->nodes) {
+        if (node.kind == FlatNode::Number)
+            program->emitPush(node.value);
+        else if (node.kind == FlatNode::Unary && node.op == '-')
+            program->emit(Neg);
+        else if (node.kind == FlatNode::Unary)
+            return fail(UndefinedOperation, 0);
+        else if (node.op == '+')
+            program->emit(Add);
+        else if (node.op == '-')
+            program->emit(Sub);
+        else if (node.op == '*')
+            program->emit(Mul);
+        else if (node.op == '/')
+            program->emit(Div);
+        else
+            return fail(UndefinedOperation, 0);
+    }
+}
+
+// Each instruction jumps straight to the next one's handler (a GCC
+// extension), so every handler has its own indirect branch to predict.
+double VirtualMachine::run(const Program &program, const double *variables)
+{
+    static const void *const handlers[] = { &&push, &&load, &&add, &&sub,
+        &&mul, &&div, &&neg, &&halt };
+
+    if (!variables && !program.variables.empty())
+        return NAN;
+
+    stack.resize(program.maxDepth + 1);
+    double *top = stack.data(); // one past the top value
+    const unsigned char *pc = program.code.data();
+
+#define DISPATCH() goto *handlers[*pc++]
+
+    DISPATCH();
+push:
+    memcpy(top++, pc, sizeof(double));
+    pc += sizeof(double);
+    DISPATCH();
+load: {
+    uint32_t slot;
+    memcpy(&slot, pc, sizeof(slot));
+    pc += sizeof(slot);
+    *top++ = variables[slot];
+    DISPATCH();
+}
+add:
+    --top;
+    top[-1] += top[0];
+    DISPATCH();
+sub:
+    --top;
+    top[-1] -= top[0];
+    DISPATCH();
+mul:
+    --top;
+    top[-1] *= top[0];
+    DISPATCH();
+div:
+    --top;
+    top[-1] /= top[0];
+    DISPATCH();
+neg:
+    top[-1] = -top[-1];
+    DISPATCH();
+halt:
+    return top[-1];
+
+#undef DISPATCH
+}
+
+// Apply op to a whole block of a with the block of b.
+template <class Op>
+static inline void applyBlock(double *__restrict a, const double *__restrict b, Op op)
+{
+    for (size_t i = 0; i < VirtualMachine::BatchSize; ++i)
+        a[i] = op(a[i], b[i]);
+}
+
+// The stack holds a block of BatchSize values per entry. The arithmetic
+// loops always run over a whole block, so their trip count is a constant
+// the compiler vectorizes for; only loads and stores stop at the rows
+// left in the last block.
+void VirtualMachine::evaluateBatch(const Program &program,
+    const double *const *columns, size_t n, double *out)
+{
+    const size_t B = BatchSize;
+    blocks.resize((program.maxDepth + 1) * B);
+
+    for (size_t row = 0; row < n; row += B) {
+        size_t rows = n - row < B ? n - row : B;
+        double *top = blocks.data(); // one past the top block
+        const unsigned char *pc = program.code.data();
+        for (;;) {
+            switch (*pc++) {
+            case Push: {
+                double value;
+                memcpy(&value, pc, sizeof(value));
+                pc += sizeof(value);
+                for (size_t i = 0; i < B; ++i)
+                    top[i] = value;
+                top += B;
+                continue;
+            }
+            case Load: {
+                uint32_t slot;
+                memcpy(&slot, pc, sizeof(slot));
+                pc += sizeof(slot);
+                memcpy(top, columns[slot] + row, rows * sizeof(double));
+                top += B;
+                continue;
+            }
+            case Add:
+                top -= B;
+                applyBlock(top - B, top, std::plus<double>());
+                continue;
+            case Sub:
+                top -= B;
+                applyBlock(top - B, top, std::minus<double>());
+                continue;
+            case Mul:
+                top -= B;
+                applyBlock(top - B, top, std::multiplies<double>());
+                continue;
+            case Div:
+                top -= B;
+                applyBlock(top - B, top, std::divides<double>());
+                continue;
+            case Neg: {
+                double *value = top - B;
+                for (size_t i = 0; i < B; ++i)
+                    value[i] = -value[i];
+                continue;
+            }
+            }
+            break; // Halt
+        }
+        memcpy(out + row, top - B, rows * sizeof(double));
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "Result.h"
+#include "VisitorPattern.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Instructions of the stack machine. Push is followed by its constant,
+// the 8 bytes of a double, right in the code, and Load by its slot, 4
+// bytes.
+enum Opcode : uint8_t {
+    Push, // push the constant that follows
+    Load, // push the value of the variable in the slot that follows
+    Add, // replace the two values on top with their sum
+    Sub, // ... their difference
+    Mul, // ... their product
+    Div, // ... their quotient
+    Neg, // negate the value on top
+    Halt // stop, the value on top is the result
+};
+
+// A compiled expression, ready to be run any number of times. Its
+// variables are numbered by slot in the order they first appear.
+class Program {
+public:
+    // A variable of the program and where it is first used.
+    struct Slot {
+        std::string name;
+        size_t offset;
+    };
+
+    Program()
+        : depth(0)
+        , maxDepth(0)
+    {
+    }
+
+    void clear()
+    {
+        code.clear();
+        variables.clear();
+        depth = maxDepth = 0;
+    }
+
+    // The slot of a variable, or -1 if the program has no such variable.
+    int slot(std::string_view name) const
+    {
+        for (size_t i = 0; i < variables.size(); ++i)
+            if (variables[i].name == name)
+                return (int)i;
+        return -1;
+    }
+
+    void emit(Opcode op)
+    {
+        code.push_back(op);
+        if (op != Neg && op != Halt)
+            --depth;
+    }
+
+    void emitPush(double value)
+    {
+        size_t at = code.size();
+        code.resize(at + 1 + sizeof(value));
+        code[at] = Push;
+        memcpy(&code[at + 1], &value, sizeof(value));
+        if (++depth > maxDepth)
+            maxDepth = depth;
+    }
+
+    void emitLoad(uint32_t slot)
+    {
+        size_t at = code.size();
+        code.resize(at + 1 + sizeof(slot));
+        code[at] = Load;
+        memcpy(&code[at + 1], &slot, sizeof(slot));
+        if (++depth > maxDepth)
+            maxDepth = depth;
+    }
+
+    std::vector<unsigned char> code;
+    std::vector<Slot> variables; // by slot
+    size_t depth; // values on the stack at the end of the code so far
+    size_t maxDepth; // stack size needed to run the code
+};
+
+// Compile a tree to a Program, operands before their operator.
+class Compiler : public Visitor {
+public:
+    CONCRETE_VISIT_METHOD_DECL(BinaryExpression);
+    CONCRETE_VISIT_METHOD_DECL(UnaryExpression);
+    CONCRETE_VISIT_METHOD_DECL(NumberLiteral);
+    CONCRETE_VISIT_METHOD_DECL(SumExpression);
+    CONCRETE_VISIT_METHOD_DECL(Variable);
+    CONCRETE_VISIT_METHOD_DECL(FlatTree);
+
+    explicit Compiler(Program *program)
+        : program(program)
+    {
+    }
+
+    // Replace the program with the code of a tree, giving each distinct
+    // variable name a slot.
+    Result<Program *> tryCompile(AbstractNode *root);
+    Result<Program *> tryCompile(FlatTree *tree);
+
+private:
+    void compile(AbstractNode *root);
+    void compileBinary(AbstractNode *binexp);
+    void compileSum(SumExpression *sum, size_t done);
+    void compileVariable(AbstractNode *variable);
+    void fail(ErrorCode code, size_t offset);
+
+    Program *program; // where code is emitted
+    Error error = { Ok, 0 }; // first error of the compilation
+};
+
+// Run Programs, dispatching each instruction with a computed goto.
+class VirtualMachine {
+public:
+    // Run once; variables holds the value of each slot. A program with
+    // variables gives NaN when there are none.
+    double run(const Program &program, const double *variables = nullptr);
+
+    // Run over n rows of variable values, column i holding the values of
+    // slot i, and store the result of each row in out. Each instruction
+    // is dispatched once per block of rows and applied to the whole
+    // block in a loop the compiler vectorizes.
+    void evaluateBatch(const Program &program, const double *const *columns,
+        size_t n, double *out);
+
+    static const size_t BatchSize = 256; // rows in a block
+
+private:
+    std::vector<double> stack; // reused from run to run
+    std::vector<double> blocks; // stack of evaluateBatch, a block per value
+};
+
+#endif /* BYTECODE_H */
@@ -14,16 +14,49 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "CharStream.h"
-#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 
-// Return the source character at the current position.
-char CharStream::currentChar() const
+void CharStream::locate(size_t offset, size_t *row, size_t *column)
 {
-    if (text.empty())
-        return EOF;
+    if (!indexed) {
+        lines.scan(data, length, origin);
+        indexed = true;
+    }
+    lines.locate(offset, row, column);
+}
+
+// A fixed buffer has nothing more to offer.
+bool CharStream::refill()
+{
+    return false;
+}
+
+// Read the next chunk over the consumed text, keeping the token being
+// scanned at the front so that it stays contiguous. The consumed chunk
+// is gone after the refill, so its lines are indexed as it arrives and
+// only those from the token on are kept.
+bool StreamCharStream::refill()
+{
+    while (!eof) {
+        size_t keep = currentOffset() - markedOffset();
+        if (keep > 0)
+            memmove(&buffer[0], textAt(markedOffset()), keep);
+        if (keep == buffer.size())
+            buffer.resize(2 * buffer.size());
 
-    if (column > text.length())
-        return EOF;
-    else
-        return text[column - 1]; // column start from 1
+        ssize_t n = read(fd, &buffer[keep], buffer.size() - keep);
+        if (n > 0) {
+            lines.discard(markedOffset());
+            lines.scan(&buffer[keep], n, currentOffset());
+            setWindow(buffer.data(), keep + n, markedOffset());
+            return true;
+        } else if (n == 0) {
+            eof = true;
+        } else if (errno != EINTR) {
+            throw "IOError: cannot read input!";
+        }
+    }
+    return false;
 }
@@ -16,42 +16,158 @@
 #ifndef CHARSTREAM_H
 #define CHARSTREAM_H
 
+#include "LineIndex.h"
+#include <stddef.h>
+#include <stdio.h>
 #include <string>
 using std::string;
 
 class CharStream {
 public:
+    static const char eof = EOF; // currentChar() at the end of the source
+
+    // Scan a private copy of the text.
     explicit CharStream(const string &text)
         : text(text)
-        , row(1)
-        , column(1)
+        , data(this->text.data())
+        , length(this->text.length())
+        , origin(0)
+        , position(0)
+        , marked(0)
+        , indexed(false)
+    {
+    }
+
+    // Scan a buffer owned by the caller (e.g. a MappedFile) without
+    // copying it. The buffer must outlive the stream.
+    CharStream(const char *data, size_t length)
+        : data(data)
+        , length(length)
+        , origin(0)
+        , position(0)
+        , marked(0)
+        , indexed(false)
+    {
+    }
+
+    virtual ~CharStream() {}
+
+    CharStream(const CharStream &) = delete;
+    CharStream &operator=(const CharStream &) = delete;
+
+    // Return the source offset of the current character.
+    size_t currentOffset() const
     {
+        return origin + position;
     }
 
-    int currentRow()
+    // Return the source text at offset, or null if it is not in memory.
+    // Text from the latest mark on is always kept in memory.
+    const char *textAt(size_t offset) const
     {
-        return row;
+        if (offset < origin || offset > origin + length)
+            return nullptr;
+        return data + (offset - origin);
     }
 
-    int currentColumn()
+    // Remember the current offset as the start of the token being scanned.
+    void mark()
     {
-        return column;
+        marked = currentOffset();
     }
 
+    size_t markedOffset() const
+    {
+        return marked;
+    }
+
+    // Resolve a source offset to 1-based row and column.
+    void locate(size_t offset, size_t *row, size_t *column);
+
     // Return the source character at the current position.
-    char currentChar() const;
+    char currentChar()
+    {
+        if (position < length || refill())
+            return data[position];
+        else
+            return EOF;
+    }
 
     // Consume the current source character and return the next character.
     char nextChar()
     {
-        ++column;
+        ++position;
         return currentChar();
     }
 
+    // Return the characters from the current position to the end of the
+    // window, which are in memory without refilling.
+    const char *current() const
+    {
+        return data + position;
+    }
+
+    size_t available() const
+    {
+        return length - position;
+    }
+
+    // Consume n of the available characters at once.
+    void skip(size_t n)
+    {
+        position += n;
+    }
+
+protected:
+    // Called when every character of the window has been consumed.
+    // Return true after making more characters available.
+    virtual bool refill();
+
+    // Replace the window by a chunk holding the source from offset start
+    // on, which includes the current position.
+    void setWindow(const char *chunk, size_t size, size_t start)
+    {
+        position = currentOffset() - start;
+        origin = start;
+        data = chunk;
+        length = size;
+    }
+
+private:
+    string text; // owned source, empty when viewing an external buffer
+    const char *data; // window of the source being scanned
+    size_t length; // window length in bytes
+    size_t origin; // source offset of the window start
+    size_t position; // current position within the window
+    size_t marked; // start offset of the latest token
+
+protected:
+    LineIndex lines; // line starts, built on the first locate()
+    bool indexed; // true once lines covers the source
+};
+
+// Pull characters from a file descriptor (e.g. a pipe on stdin) through
+// a fixed-size buffer that is refilled in place as scanning moves
+// forward, so input of any length is scanned in constant memory. The
+// buffer only grows when a single token does not fit in it.
+class StreamCharStream : public CharStream {
+public:
+    explicit StreamCharStream(int fd, size_t capacity = 64 * 1024)
+        : CharStream(nullptr, 0)
+        , fd(fd)
+        , buffer(capacity, '\0')
+        , eof(false)
+    {
+        indexed = true; // lines are recorded chunk by chunk
+    }
+
+protected:
+    bool refill();
+
 private:
-    string text; // source line
-    int row; // current line number
-    int column; // current line position, start from 1
+    int fd; // source descriptor, not owned
+    string buffer; // chunk storage
+    bool eof; // true once read() reported end of input
 };
 
 #endif /* CHARSTREAM_H */
@@ -0,0 +1,181 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXPRESSION_BUILDER_H
+#define EXPRESSION_BUILDER_H
+
+#include "AbstractSyntaxTree.h"
+#include "FlatTree.h"
+#include "Result.h"
+#include "Value.h"
+#include <math.h>
+#include <memory_resource>
+#include <string.h>
+
+// Builders turn what the parser recognizes into some representation of
+// the expression. The parser calls them in post-order, operands first:
+//     Node number(const Token &literal)
+//     Node variable(const Token &name, const char *text)
+//     Node unary(const Token &op, Node operand)
+//     Node binary(const Token &op, Node lhs, Node rhs)
+// variable() only if the builder's variables is true; otherwise the
+// parser reports a variable as unknown.
+
+// What every builder shares: the first operation it could not build.
+// Such an operation still yields a node, and the parser reports the
+// error when the expression ends.
+class ExpressionBuilder {
+public:
+    Error error = { Ok, 0 };
+
+protected:
+    void fail(const Token &op)
+    {
+        if (error.code == Ok)
+            error = Error{ UndefinedOperation, op.offset };
+    }
+};
+
+// Build the pointer tree, nodes allocated from a memory resource.
+class TreeBuilder : public ExpressionBuilder {
+public:
+    typedef AbstractNode *Node;
+    static const bool variables = true;
+
+    explicit TreeBuilder(std::pmr::memory_resource *resource)
+        : resource(resource)
+    {
+    }
+
+    Node number(const Token &literal)
+    {
+        return newNode<NumberLiteral>(resource, literal);
+    }
+
+    // The name is copied, as the source text may not outlive the tree.
+    Node variable(const Token &name, const char *text)
+    {
+        Variable *node = newNode<Variable>(resource, name);
+        char *copy = (char *)resource->allocate(name.length, 1);
+        memcpy(copy, text, name.length);
+        node->name = std::string_view(copy, name.length);
+        return node;
+    }
+
+    Node unary(const Token &op, Node operand)
+    {
+        Node node = newNode<UnaryExpression>(resource, op);
+        node->addChild(operand);
+        return node;
+    }
+
+    Node binary(const Token &op, Node lhs, Node rhs)
+    {
+        Node node = newNode<BinaryExpression>(resource, op);
+        node->addChild(lhs);
+        node->addChild(rhs);
+        return node;
+    }
+
+private:
+    std::pmr::memory_resource *resource; // where nodes are allocated
+};
+
+// Append nodes to a FlatTree; a node is named by its index.
+class FlatTreeBuilder : public ExpressionBuilder {
+public:
+    typedef uint32_t Node;
+    static const bool variables = false;
+
+    explicit FlatTreeBuilder(FlatTree *tree)
+        : tree(tree)
+    {
+    }
+
+    Node number(const Token &literal)
+    {
+        return tree->addNumber(literal.number());
+    }
+
+    Node unary(const Token &op, Node)
+    {
+        return tree->addUnary(symbol(op));
+    }
+
+    Node binary(const Token &op, Node lhs, Node)
+    {
+        return tree->addBinary(symbol(op), lhs);
+    }
+
+private:
+    char symbol(const Token &op)
+    {
+        switch (op.type) {
+        case Token::Plus:
+            return '+';
+        case Token::Minus:
+            return '-';
+        case Token::Star:
+            return '*';
+        case Token::Slash:
+            return '/';
+        default:
+            fail(op);
+            return '?';
+        }
+    }
+
+    FlatTree *tree; // where nodes are appended
+};
+
+// Fold each operator into a value as soon as its operands are known, so
+// no node is ever built: memory is bounded by the nesting depth.
+class ValueBuilder : public ExpressionBuilder {
+public:
+    typedef Value Node;
+    static const bool variables = false;
+
+    Node number(const Token &literal)
+    {
+        return Value::of(literal);
+    }
+
+    Node unary(const Token &op, Node operand)
+    {
+        if (op.type == Token::Minus)
+            return negate(operand);
+        fail(op);
+        return Value::ofReal(NAN);
+    }
+
+    Node binary(const Token &op, Node lhs, Node rhs)
+    {
+        switch (op.type) {
+        case Token::Plus:
+            return add(lhs, rhs);
+        case Token::Minus:
+            return subtract(lhs, rhs);
+        case Token::Star:
+            return multiply(lhs, rhs);
+        case Token::Slash:
+            return divide(lhs, rhs);
+        default:
+            fail(op);
+            return Value::ofReal(NAN);
+        }
+    }
+};
+
+#endif /* EXPRESSION_BUILDER_H */
@@ -0,0 +1,61 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ExpressionCache.h"
+
+const ExpressionCache::Entry *ExpressionCache::find(const std::string &key)
+{
+    auto found = index.find(key);
+    if (found == index.end()) {
+        ++missCount;
+        return nullptr;
+    }
+    ++hitCount;
+    entries.splice(entries.begin(), entries, found->second);
+    return &found->second->entry;
+}
+
+void ExpressionCache::insert(const std::string &key, Entry entry)
+{
+    auto found = index.find(key);
+    if (found != index.end()) {
+        byteCount -= footprint(*found->second);
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    entries.push_front(Node{ key, std::move(entry) });
+    index.emplace(entries.front().key, entries.begin());
+    byteCount += footprint(entries.front());
+
+    while (byteCount > byteLimit && !entries.empty())
+        evict();
+}
+
+// Key, the list node and the index slot pointing at it.
+size_t ExpressionCache::footprint(const Node &node)
+{
+    return node.key.capacity() + sizeof(Node) + 2 * sizeof(void *)
+        + sizeof(std::pair<std::string_view, Position>) + sizeof(void *);
+}
+
+void ExpressionCache::evict()
+{
+    Node &last = entries.back();
+    byteCount -= footprint(last);
+    index.erase(last.key);
+    entries.pop_back();
+    ++evictionCount;
+}
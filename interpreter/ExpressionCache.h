@@ -0,0 +1,124 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXPRESSION_CACHE_H
+#define EXPRESSION_CACHE_H
+
+#include "Token.h"
+#include "Value.h"
+#include <list>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Bounded LRU cache of expression values. Entries are keyed by the
+// normalized token stream of the source, i.e. token types and number
+// values without the text between tokens, so "1+2" and "1 + 2" share an
+// entry. An integer literal is kept apart from a real one, since its
+// answer is computed exactly: "1.0+2" has its own entry. The size limit
+// counts the keys and the bookkeeping of each entry.
+class ExpressionCache {
+public:
+    struct Entry {
+        Value value; // value of the expression
+    };
+
+    explicit ExpressionCache(size_t byteLimit)
+        : byteLimit(byteLimit)
+        , byteCount(0)
+        , hitCount(0)
+        , missCount(0)
+        , evictionCount(0)
+    {
+    }
+
+    ExpressionCache(const ExpressionCache &) = delete;
+    ExpressionCache &operator=(const ExpressionCache &) = delete;
+
+    // Normalize the tokens of a scanner into key. Return false if an
+    // Invalid token or an Identifier was met: such text is an error, not
+    // worth caching.
+    template <class TokenScanner>
+    static bool normalize(TokenScanner *scanner, std::string *key);
+
+    // The entry of a key, now the most recently used, or nullptr.
+    const Entry *find(const std::string &key);
+
+    // Add an entry, evicting the least recently used ones to stay within
+    // the size limit. An entry larger than the limit is not kept.
+    void insert(const std::string &key, Entry entry);
+
+    size_t hits() const
+    {
+        return hitCount;
+    }
+
+    size_t misses() const
+    {
+        return missCount;
+    }
+
+    size_t evictions() const
+    {
+        return evictionCount;
+    }
+
+    size_t bytes() const
+    {
+        return byteCount;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        Entry entry;
+    };
+
+    typedef std::list<Node>::iterator Position;
+
+    static size_t footprint(const Node &node);
+    void evict();
+
+    std::list<Node> entries; // most recently used first
+    std::unordered_map<std::string_view, Position> index; // keys view entries
+    size_t byteLimit; // bound on bytes()
+    size_t byteCount; // size of all entries
+    size_t hitCount;
+    size_t missCount;
+    size_t evictionCount;
+};
+
+template <class TokenScanner>
+bool ExpressionCache::normalize(TokenScanner *scanner, std::string *key)
+{
+    key->clear();
+    for (const Token *token = &scanner->currentToken(); token->type != EOF;
+         token = &scanner->nextToken()) {
+        if (token->type == Token::Invalid || token->type == Token::Identifier)
+            return false;
+        key->push_back((char)token->type);
+        if (token->type == Token::Number && token->flags & Token::Integer) {
+            key->push_back('i');
+            key->append((const char *)&token->integer, sizeof(token->integer));
+        } else if (token->type == Token::Number) {
+            key->push_back('r');
+            key->append((const char *)&token->value, sizeof(token->value));
+        }
+    }
+    return true;
+}
+
+#endif /* EXPRESSION_CACHE_H */
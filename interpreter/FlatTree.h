@@ -0,0 +1,80 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FLAT_TREE_H
+#define FLAT_TREE_H
+
+#include "VisitorPattern.h"
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+// A node of FlatTree, 16 bytes. The operand of a unary node and the
+// right operand of a binary node are always the node just before it, so
+// only a binary node's left operand needs an index.
+struct FlatNode {
+    enum Kind : uint8_t { Number,
+        Unary,
+        Binary };
+
+    uint8_t kind;
+    char op; // '+' '-' '*' '/' of a Binary node, '-' of a Unary node
+    uint32_t lhs; // index of the left operand of a Binary node
+    double value; // value of a Number node
+};
+
+static_assert(sizeof(FlatNode) == 16, "FlatNode should stay 16 bytes");
+static_assert(std::is_trivially_copyable<FlatNode>::value,
+              "FlatNode should stay trivially copyable");
+
+// Expression tree stored as one array of nodes in post-order: operands
+// come before their operator and the root is the last node, so a visitor
+// can evaluate it in a single pass over memory.
+class FlatTree {
+public:
+    CONCRETE_ACCEPT_METHOD_DECL
+
+    uint32_t addNumber(double value)
+    {
+        FlatNode node = { FlatNode::Number, 0, 0, value };
+        nodes.push_back(node);
+        return (uint32_t)nodes.size() - 1;
+    }
+
+    // The operand must be the latest node added.
+    uint32_t addUnary(char op)
+    {
+        FlatNode node = { FlatNode::Unary, op, 0, 0 };
+        nodes.push_back(node);
+        return (uint32_t)nodes.size() - 1;
+    }
+
+    // The right operand must be the latest node added.
+    uint32_t addBinary(char op, uint32_t lhs)
+    {
+        FlatNode node = { FlatNode::Binary, op, lhs, 0 };
+        nodes.push_back(node);
+        return (uint32_t)nodes.size() - 1;
+    }
+
+    void clear()
+    {
+        nodes.clear();
+    }
+
+    std::vector<FlatNode> nodes;
+};
+
+#endif /* FLAT_TREE_H */
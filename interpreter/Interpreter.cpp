@@ -15,24 +15,173 @@
 
 #include "Interpreter.h"
 #include "AbstractSyntaxTree.h"
-#include <stdlib.h>
+#include "FlatTree.h"
+#include "PairwiseSum.h"
+#include "TreeWalker.h"
+#include <math.h>
+
+Result<Value> Interpreter::tryEvaluate(AbstractNode *root)
+{
+    root->accept(this);
+    if (error.code != Ok)
+        return error;
+    return ans;
+}
+
+Result<Value> Interpreter::tryEvaluate(FlatTree *tree)
+{
+    tree->accept(this);
+    if (error.code != Ok)
+        return error;
+    return ans;
+}
+
+Value Interpreter::answer() const
+{
+    if (error.code != Ok)
+        throw errorMessage(error.code);
+    return ans;
+}
+
+// Remember the first error; the result is NaN from there on.
+void Interpreter::fail(ErrorCode code, size_t offset)
+{
+    if (error.code == Ok)
+        error = Error{ code, offset };
+    ans = Value::ofReal(NAN);
+}
+
+// The children of a node are evaluated onto the end of the values stack
+// before the node itself, so that depth costs no C++ stack.
+void Interpreter::evaluate(AbstractNode *root)
+{
+    error = Error{ Ok, 0 };
+    size_t base = values.size();
+    walkTree(root, [this](AbstractNode *node, size_t done) {
+        size_t n = node->children.size();
+        if (done < n)
+            return;
+        Value *top = values.data() + values.size();
+        switch (node->kind) {
+        case NodeKind::NumberLiteral:
+            values.push_back(Value::of(node->token));
+            return;
+        case NodeKind::UnaryExpression:
+            if (node->op == Operator::Negate)
+                top[-1] = negate(top[-1]);
+            else
+                top[-1] = failure(node, UndefinedOperation);
+            return;
+        case NodeKind::BinaryExpression:
+            top[-2] = apply(node, top[-2], top[-1]);
+            values.pop_back();
+            return;
+        case NodeKind::SumExpression: {
+            SumExpression *sum = static_cast<SumExpression *>(node);
+            Value *children = top - n;
+            terms.resize(n);
+            for (size_t i = 0; i < n; ++i)
+                terms[i] = sum->signs[i] * children[i].toDouble();
+            double value = pairwiseSum(sum->terms.data(), sum->terms.size())
+                + pairwiseSum(terms.data(), n);
+            values.resize(values.size() - n);
+            values.push_back(Value::ofReal(value));
+            return;
+        }
+        case NodeKind::Variable:
+            values.push_back(failure(node, UnknownVariable));
+            return;
+        }
+    });
+    ans = values.back();
+    values.resize(base);
+    if (error.code != Ok)
+        ans = Value::ofReal(NAN);
+}
+
+Value Interpreter::apply(AbstractNode *node, Value a, Value b)
+{
+    switch (node->op) {
+    case Operator::Add:
+        return add(a, b);
+    case Operator::Subtract:
+        return subtract(a, b);
+    case Operator::Multiply:
+        return multiply(a, b);
+    case Operator::Divide:
+        return divide(a, b);
+    default:
+        return failure(node, UndefinedOperation);
+    }
+}
+
+// Record the error of a node that cannot be evaluated and yield its NaN.
+Value Interpreter::failure(AbstractNode *node, ErrorCode code)
+{
+    fail(code, node->token.offset);
+    return Value::ofReal(NAN);
+}
 
 void Interpreter::visit(BinaryExpression *binexp)
 {
-    binexp->children[0]->accept(this);
-    double a = ans;
-    binexp->children[1]->accept(this);
-    double b = ans;
+    evaluate(binexp);
+}
 
-    if (binexp->token->text == "+")
-        ans = a + b;
-    else if (binexp->token->text == "-")
-        ans = a - b;
-    else
-        throw "Undefined operation!";
+void Interpreter::visit(UnaryExpression *unexp)
+{
+    evaluate(unexp);
 }
 
 void Interpreter::visit(NumberLiteral *integer)
 {
-    ans = atof(integer->token->text.c_str());
+    error = Error{ Ok, 0 };
+    ans = Value::of(integer->token);
+}
+
+void Interpreter::visit(SumExpression *sum)
+{
+    evaluate(sum);
+}
+
+void Interpreter::visit(Variable *variable)
+{
+    error = Error{ Ok, 0 };
+    fail(UnknownVariable, variable->token.offset);
+}
+
+// A flat tree keeps no source offsets, so its errors are at offset 0.
+void Interpreter::visit(FlatTree *tree)
+{
+    error = Error{ Ok, 0 };
+    if (tree->nodes.empty())
+        return fail(NumberExpected, 0);
+
+    // operands of a post-order node are on top of the stack
+    operands.resize(tree->nodes.size());
+    double *top = operands.data();
+    for (const FlatNode &node : tree->nodes) {
+        if (node.kind == FlatNode::Number) {
+            *top++ = node.value;
+            continue;
+        }
+        if (node.kind == FlatNode::Unary) {
+            if (node.op != '-')
+                return fail(UndefinedOperation, 0);
+            top[-1] = -top[-1];
+            continue;
+        }
+        double b = *--top;
+        double a = *--top;
+        if (node.op == '+')
+            *top++ = a + b;
+        else if (node.op == '-')
+            *top++ = a - b;
+        else if (node.op == '*')
+            *top++ = a * b;
+        else if (node.op == '/')
+            *top++ = a / b;
+        else
+            return fail(UndefinedOperation, 0);
+    }
+    ans = Value::ofReal(operands[0]);
 }
@@ -16,20 +16,42 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "Result.h"
+#include "Value.h"
 #include "VisitorPattern.h"
+#include <vector>
 
 class Interpreter : public Visitor {
 public:
     CONCRETE_VISIT_METHOD_DECL(BinaryExpression);
+    CONCRETE_VISIT_METHOD_DECL(UnaryExpression);
     CONCRETE_VISIT_METHOD_DECL(NumberLiteral);
+    CONCRETE_VISIT_METHOD_DECL(SumExpression);
+    CONCRETE_VISIT_METHOD_DECL(Variable);
+    CONCRETE_VISIT_METHOD_DECL(FlatTree);
 
-    double answer() const
-    {
-        return ans;
-    }
+    // Evaluate a tree; an undefined operation or a variable, which has
+    // no value here, comes back as an error.
+    // Integer literals are computed exactly as far as Value allows, but
+    // the terms of a SumExpression and a FlatTree hold doubles only.
+    Result<Value> tryEvaluate(AbstractNode *root);
+    Result<Value> tryEvaluate(FlatTree *tree);
+
+    // The latest result, or throw the message of the first error found
+    // while evaluating the latest tree.
+    Value answer() const;
 
 private:
-    double ans; // the latest result
+    void evaluate(AbstractNode *root);
+    Value apply(AbstractNode *node, Value a, Value b);
+    Value failure(AbstractNode *node, ErrorCode code);
+    void fail(ErrorCode code, size_t offset);
+
+    Value ans; // the latest result
+    Error error = { Ok, 0 }; // first error of the evaluation
+    std::vector<double> operands; // stack of a FlatTree evaluation
+    std::vector<double> terms; // values of the SumExpression children
+    std::vector<Value> values; // stack of a tree evaluation
 };
 
 #endif /* INTERPRETER_H */
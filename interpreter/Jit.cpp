@@ -0,0 +1,238 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Jit.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+JitExpression::JitExpression(bool perfMap)
+    : perfMap(perfMap)
+    , function(nullptr)
+    , pages(nullptr)
+    , size(0)
+    , root(nullptr)
+{
+}
+
+JitExpression::~JitExpression()
+{
+    release();
+}
+
+void JitExpression::release()
+{
+    if (pages)
+        munmap(pages, size);
+    function = nullptr;
+    pages = nullptr;
+    size = 0;
+}
+
+Result<bool> JitExpression::compile(AbstractNode *root)
+{
+    release();
+    this->root = root;
+
+    Program program;
+    Compiler compiler(&program);
+    Result<Program *> compiled = compiler.tryCompile(root);
+    if (!compiled.ok())
+        return Error{ compiled.code(), compiled.offset() };
+    // the function takes no arguments to give variables values
+    if (!program.variables.empty())
+        return Error{ UnknownVariable, program.variables[0].offset };
+
+    return generate(program);
+}
+
+#if defined(__x86_64__)
+
+namespace {
+
+// Machine code and the constants it loads, laid out after the code.
+class Assembler {
+public:
+    // op xmm(a), xmm(b) for the scalar double instructions (F2 0F op)
+    void scalar(uint8_t op, unsigned a, unsigned b)
+    {
+        code.push_back(0xF2);
+        rex(a, b);
+        code.push_back(0x0F);
+        code.push_back(op);
+        code.push_back(0xC0 | (a & 7) << 3 | (b & 7));
+    }
+
+    // movsd xmm(a), [rip + constant]
+    void load(unsigned a, double value)
+    {
+        code.push_back(0xF2);
+        rex(a, 0);
+        code.push_back(0x0F);
+        code.push_back(0x10);
+        constant(a, value);
+    }
+
+    // xorpd xmm(a), [rip + sign mask]
+    void negate(unsigned a)
+    {
+        code.push_back(0x66);
+        rex(a, 0);
+        code.push_back(0x0F);
+        code.push_back(0x57);
+        fixups.push_back(Fixup{ emitRipOperand(a), -1 });
+    }
+
+    void ret()
+    {
+        code.push_back(0xC3);
+    }
+
+    // Code, then the 16-byte sign mask and the constants.
+    std::vector<uint8_t> link() const
+    {
+        std::vector<uint8_t> image(code);
+        image.resize((image.size() + 15) & ~(size_t)15);
+        size_t pool = image.size();
+        uint64_t mask[2] = { 0x8000000000000000ull, 0 };
+        image.insert(image.end(), (uint8_t *)mask, (uint8_t *)(mask + 2));
+        image.insert(image.end(), (const uint8_t *)constants.data(),
+            (const uint8_t *)(constants.data() + constants.size()));
+
+        for (const Fixup &fixup : fixups) {
+            size_t target = fixup.constant < 0 ? pool : pool + 16 + 8 * fixup.constant;
+            int32_t displacement = (int32_t)(target - (fixup.at + 4));
+            memcpy(&image[fixup.at], &displacement, 4);
+        }
+        return image;
+    }
+
+private:
+    struct Fixup {
+        size_t at; // where the 32-bit displacement goes
+        long constant; // which constant, -1 for the sign mask
+    };
+
+    void rex(unsigned reg, unsigned rm)
+    {
+        if (reg >= 8 || rm >= 8)
+            code.push_back(0x40 | (reg >= 8) << 2 | (rm >= 8));
+    }
+
+    size_t emitRipOperand(unsigned reg)
+    {
+        code.push_back(0x05 | (reg & 7) << 3);
+        size_t at = code.size();
+        code.resize(at + 4);
+        return at;
+    }
+
+    void constant(unsigned reg, double value)
+    {
+        fixups.push_back(Fixup{ emitRipOperand(reg), (long)constants.size() });
+        constants.push_back(value);
+    }
+
+    std::vector<uint8_t> code;
+    std::vector<double> constants;
+    std::vector<Fixup> fixups;
+};
+
+} // namespace
+
+// Slot i of the bytecode stack is xmm(i); the result ends in xmm0, where
+// the calling convention returns a double.
+bool JitExpression::generate(const Program &program)
+{
+    if (program.maxDepth > Registers)
+        return false;
+
+    Assembler assembler;
+    unsigned depth = 0;
+    const unsigned char *pc = program.code.data();
+    for (;;) {
+        switch (*pc++) {
+        case Push: {
+            double value;
+            memcpy(&value, pc, sizeof(value));
+            pc += sizeof(value);
+            assembler.load(depth++, value);
+            break;
+        }
+        case Add:
+            --depth;
+            assembler.scalar(0x58, depth - 1, depth);
+            break;
+        case Sub:
+            --depth;
+            assembler.scalar(0x5C, depth - 1, depth);
+            break;
+        case Mul:
+            --depth;
+            assembler.scalar(0x59, depth - 1, depth);
+            break;
+        case Div:
+            --depth;
+            assembler.scalar(0x5E, depth - 1, depth);
+            break;
+        case Neg:
+            assembler.negate(depth - 1);
+            break;
+        case Halt:
+            assembler.ret();
+            goto done;
+        }
+    }
+done:
+
+    std::vector<uint8_t> image = assembler.link();
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t length = (image.size() + page - 1) / page * page;
+    void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        return false;
+    memcpy(addr, image.data(), image.size());
+    if (mprotect(addr, length, PROT_READ | PROT_EXEC) < 0) {
+        munmap(addr, length);
+        return false;
+    }
+
+    pages = addr;
+    size = length;
+    function = (Function)addr;
+
+    if (perfMap) {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+        if (FILE *file = fopen(path, "a")) {
+            fprintf(file, "%lx %zx jit_expression\n", (unsigned long)addr, image.size());
+            fclose(file);
+        }
+    }
+    return true;
+}
+
+#else
+
+bool JitExpression::generate(const Program &)
+{
+    return false;
+}
+
+#endif /* __x86_64__ */
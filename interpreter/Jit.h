@@ -0,0 +1,77 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include "Bytecode.h"
+#include "Interpreter.h"
+#include "Result.h"
+#include <math.h>
+#include <stddef.h>
+
+// An expression compiled to x86-64 SSE2 code. The tree is compiled to
+// bytecode first, and each stack slot of the bytecode becomes one of
+// the 16 xmm registers; the code lives in its own pages, writable while
+// it is generated and then only executable.
+//
+// On other architectures, when the expression needs more than 16 slots
+// or when no pages can be mapped, run() evaluates the tree with the
+// Interpreter instead, so the tree must outlive the JitExpression.
+class JitExpression {
+public:
+    typedef double (*Function)();
+
+    // With perfMap, each compiled function is listed in
+    // /tmp/perf-<pid>.map, so that perf can name it.
+    explicit JitExpression(bool perfMap = false);
+    ~JitExpression();
+
+    JitExpression(const JitExpression &) = delete;
+    JitExpression &operator=(const JitExpression &) = delete;
+
+    // Compile a tree, replacing any previous code. The value tells
+    // whether native code was generated.
+    Result<bool> compile(AbstractNode *root);
+
+    // Without native code, an error of the Interpreter gives NaN.
+    double run()
+    {
+        if (function)
+            return function();
+        Result<Value> value = interpreter.tryEvaluate(root);
+        return value.ok() ? value.value().toDouble() : NAN;
+    }
+
+    bool native() const
+    {
+        return function != nullptr;
+    }
+
+private:
+    bool generate(const Program &program);
+    void release();
+
+    static const size_t Registers = 16; // xmm0..xmm15
+
+    bool perfMap; // list functions for perf
+    Function function; // the native code, or null
+    void *pages; // mapping holding the code
+    size_t size; // its size
+    AbstractNode *root; // tree to interpret without native code
+    Interpreter interpreter;
+};
+
+#endif /* JIT_H */
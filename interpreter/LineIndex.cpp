@@ -0,0 +1,47 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LineIndex.h"
+#include <algorithm>
+#include <string.h>
+
+void LineIndex::scan(const char *chunk, size_t size, size_t base)
+{
+    const char *end = chunk + size;
+    const char *p = chunk;
+    while ((p = static_cast<const char *>(memchr(p, '\n', end - p))) != nullptr) {
+        ++p;
+        starts.push_back(base + (p - chunk));
+    }
+}
+
+void LineIndex::discard(size_t offset)
+{
+    auto line = std::upper_bound(starts.begin(), starts.end(), offset) - 1;
+    if (line <= starts.begin())
+        return;
+    dropped += line - starts.begin();
+    starts.erase(starts.begin(), line);
+}
+
+void LineIndex::locate(size_t offset, size_t *row, size_t *column) const
+{
+    auto line = std::upper_bound(starts.begin(), starts.end(), offset);
+    if (line != starts.begin())
+        --line;
+    offset = std::max(offset, *line);
+    *row = dropped + (line - starts.begin()) + 1;
+    *column = offset - *line + 1;
+}
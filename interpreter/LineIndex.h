@@ -0,0 +1,49 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stddef.h>
+#include <vector>
+
+// Sorted start offsets of the source lines. Positions are kept as plain
+// byte offsets everywhere else and only turned into rows and columns
+// here, when a message is reported.
+class LineIndex {
+public:
+    LineIndex()
+        : starts(1, 0)
+        , dropped(0)
+    {
+    }
+
+    // Record the lines starting in a chunk of source found at offset base.
+    void scan(const char *chunk, size_t size, size_t base);
+
+    // Forget the lines that end before offset, keeping only their count,
+    // so that a streamed source is indexed in memory bounded by its
+    // buffer. Offsets before the oldest line kept resolve to its start.
+    void discard(size_t offset);
+
+    // Resolve a source offset to 1-based row and column.
+    void locate(size_t offset, size_t *row, size_t *column) const;
+
+private:
+    std::vector<size_t> starts; // offset of the first character of each line
+    size_t dropped; // number of lines discarded before starts.front()
+};
+
+#endif /* LINE_INDEX_H */
@@ -0,0 +1,203 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "NumberParser.h"
+#include "PowersOfFive.h"
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+
+// Powers of ten that a double holds exactly.
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Full 128-bit product of two 64-bit words.
+static inline void multiply(uint64_t a, uint64_t b, uint64_t *high, uint64_t *low)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (uint64_t)(product >> 64);
+    *low = (uint64_t)product;
+#else
+    uint64_t aLow = (uint32_t)a, aHigh = a >> 32;
+    uint64_t bLow = (uint32_t)b, bHigh = b >> 32;
+    uint64_t ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+    uint64_t middle = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *low = (middle << 32) | (uint32_t)ll;
+    *high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+#endif
+}
+
+// Eisel-Lemire algorithm (D. Lemire, "Number Parsing at a Gigabyte per
+// Second", 2021): multiply the normalized mantissa by a 128-bit
+// approximation of 5^q and round, giving up when the truncated product
+// cannot tell which way the exact value rounds.
+static bool eiselLemire(uint64_t w, int64_t q, double *value)
+{
+    const int mantissaBits = 52;
+    const int minimumExponent = -1023;
+    const int64_t infinitePower = 0x7FF;
+
+    if (w == 0 || q < smallestPowerOfFive) {
+        *value = 0;
+        return true;
+    }
+    if (q > largestPowerOfFive) {
+        *value = HUGE_VAL;
+        return true;
+    }
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    int index = 2 * (int)(q - smallestPowerOfFive);
+    uint64_t high, low;
+    multiply(w, powersOfFive[index], &high, &low);
+    const uint64_t precisionMask = 0xFFFFFFFFFFFFFFFFULL >> (mantissaBits + 3);
+    if ((high & precisionMask) == precisionMask) {
+        uint64_t high2, low2;
+        multiply(w, powersOfFive[index + 1], &high2, &low2);
+        low += high2;
+        if (high2 > low)
+            ++high;
+    }
+    if (low == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55))
+        return false;
+
+    int upperbit = (int)(high >> 63);
+    int shift = upperbit + 64 - mantissaBits - 3;
+    uint64_t mantissa = high >> shift;
+    int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz - minimumExponent;
+
+    if (power2 <= 0) {
+        // subnormal result
+        if (-power2 + 1 >= 64) {
+            *value = 0;
+            return true;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (1ULL << mantissaBits) ? 0 : 1;
+    } else {
+        // exactly halfway between two doubles: round to even
+        if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1
+            && (mantissa << shift) == high)
+            mantissa &= ~1ULL;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        if (mantissa >= (2ULL << mantissaBits)) {
+            mantissa = 1ULL << mantissaBits;
+            ++power2;
+        }
+        mantissa &= ~(1ULL << mantissaBits);
+        if (power2 >= infinitePower) {
+            power2 = infinitePower;
+            mantissa = 0;
+        }
+    }
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << mantissaBits);
+    memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+bool composeNumber(uint64_t mantissa, int64_t exponent, double *value)
+{
+    // Clinger's fast path: both operands exact, so one rounding only.
+    if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double m = (double)mantissa;
+        *value = exponent < 0 ? m / exactPowersOfTen[-exponent]
+                              : m * exactPowersOfTen[exponent];
+        return true;
+    }
+    return eiselLemire(mantissa, exponent, value);
+}
+
+double decodeNumber(const char *text, size_t length)
+{
+    const char *p = text, *end = text + length;
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    int digits = 0; // significant digits in mantissa
+    bool fraction = false;
+
+    while (p < end) {
+        uint64_t chunk;
+        if (end - p >= 8 && digits + 8 <= maxMantissaDigits && loadEightDigits(p, &chunk)) {
+            mantissa = mantissa * 100000000 + parseEightDigits(chunk);
+            digits += 8;
+            exponent -= fraction ? 8 : 0;
+            p += 8;
+        } else if (*p >= '0' && *p <= '9') {
+            if (mantissa != 0 || *p != '0')
+                ++digits;
+            mantissa = mantissa * 10 + (*p++ - '0');
+            exponent -= fraction ? 1 : 0;
+        } else if (*p == '.' && !fraction) {
+            fraction = true;
+            ++p;
+        } else {
+            break;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        bool negative = ++p < end && *p == '-';
+        if (p < end && (*p == '+' || *p == '-'))
+            ++p;
+        int64_t e = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (e < 100000)
+                e = e * 10 + (*p - '0');
+            ++p;
+        }
+        exponent += negative ? -e : e;
+    }
+
+    double value;
+    if (digits > maxMantissaDigits || p != end || !composeNumber(mantissa, exponent, &value))
+        return decodeNumberExact(text, length);
+    return value;
+}
+
+bool decodeInteger(const char *text, size_t length, int64_t *value)
+{
+    int64_t n = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] < '0' || text[i] > '9')
+            return false;
+        if (__builtin_mul_overflow(n, 10, &n) || __builtin_add_overflow(n, text[i] - '0', &n))
+            return false;
+    }
+    *value = n;
+    return true;
+}
+
+double decodeNumberExact(const char *text, size_t length)
+{
+    static locale_t cLocale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+
+    char buffer[64];
+    if (length < sizeof(buffer)) {
+        memcpy(buffer, text, length);
+        buffer[length] = '\0';
+        return strtod_l(buffer, nullptr, cLocale);
+    }
+    return strtod_l(std::string(text, length).c_str(), nullptr, cLocale);
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NUMBER_PARSER_H
+#define NUMBER_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Most significant decimal digits kept exactly in a 64-bit mantissa.
+const int maxMantissaDigits = 19;
+
+// Return true if the 8 bytes of chunk, in memory order, are all digits.
+inline bool isEightDigits(uint64_t chunk)
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+               | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        == 0x3333333333333333ULL;
+}
+
+// Return the value of 8 digits loaded little-endian, by SWAR arithmetic.
+inline uint32_t parseEightDigits(uint64_t chunk)
+{
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 0x000F424000000064ULL; // 100 + (1000000 << 32)
+    const uint64_t mul2 = 0x0000271000000001ULL; // 1 + (10000 << 32)
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)chunk;
+}
+
+// Load 8 characters for the SWAR helpers; false where that is not possible.
+inline bool loadEightDigits(const char *text, uint64_t *chunk)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(chunk, text, 8);
+    return isEightDigits(*chunk);
+#else
+    (void)text;
+    (void)chunk;
+    return false;
+#endif
+}
+
+// Store mantissa * 10^exponent, correctly rounded, in *value. Return
+// false in the rare cases the fast algorithms cannot decide.
+bool composeNumber(uint64_t mantissa, int64_t exponent, double *value);
+
+// Convert the text of a Number token, which need not be null-terminated,
+// to its value.
+double decodeNumber(const char *text, size_t length);
+
+// Store the value of a Number text of digits only in *value. Return false
+// if the text has a fraction or an exponent, or overflows 64 bits.
+bool decodeInteger(const char *text, size_t length, int64_t *value);
+
+// Slow but always exact conversion, independent of the locale.
+double decodeNumberExact(const char *text, size_t length);
+
+#endif /* NUMBER_PARSER_H */
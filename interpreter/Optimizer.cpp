@@ -0,0 +1,288 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Optimizer.h"
+#include "PairwiseSum.h"
+#include "SumFlattening.h"
+#include "TreeWalker.h"
+#include "Value.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+
+// Rewrite every node after its children, replacing it by what rewrite()
+// returns for it; return the new root.
+template <class Rewrite>
+static AbstractNode *rewriteTree(AbstractNode *root, Rewrite &&rewrite)
+{
+    walkTree(root, [&rewrite](AbstractNode *node, size_t done) {
+        if (done < node->children.size())
+            return;
+        for (AbstractNode *&child : node->children)
+            child = rewrite(child);
+    });
+    return rewrite(root);
+}
+
+static size_t countNodes(AbstractNode *root)
+{
+    size_t count = 0;
+    walkTree(root, [&count](AbstractNode *, size_t done) {
+        count += done == 0;
+    });
+    return count;
+}
+
+static bool isLiteral(const AbstractNode *node)
+{
+    return node->kind == NodeKind::NumberLiteral;
+}
+
+// A literal of value, at the source position of the node it replaces.
+static AbstractNode *newLiteral(const AbstractNode *at, Value value,
+    std::pmr::memory_resource *resource)
+{
+    Token token(Token::Number, at->token.offset, at->token.length);
+    if (value.kind == Value::Integer) {
+        token.flags = Token::Integer;
+        token.integer = value.integer;
+    } else {
+        token.value = value.real;
+    }
+    return newNode<NumberLiteral>(resource, token);
+}
+
+// In double arithmetic, literals are folded as Reals, so that no integer
+// is computed exactly.
+AbstractNode *ConstantFolding::run(AbstractNode *root,
+    std::pmr::memory_resource *resource)
+{
+    bool doubles = arithmetic == Arithmetic::Double;
+    auto literal = [doubles](AbstractNode *node) {
+        Value value = Value::of(node->token);
+        return doubles ? Value::ofReal(value.toDouble()) : value;
+    };
+
+    return rewriteTree(root, [resource, &literal](AbstractNode *node) {
+        if (node->kind == NodeKind::UnaryExpression && node->op == Operator::Negate
+            && isLiteral(node->children[0]))
+            return newLiteral(node, negate(literal(node->children[0])), resource);
+
+        if (node->kind != NodeKind::BinaryExpression || !isLiteral(node->children[0])
+            || !isLiteral(node->children[1]))
+            return node;
+        Value a = literal(node->children[0]);
+        Value b = literal(node->children[1]);
+        switch (node->op) {
+        case Operator::Add:
+            return newLiteral(node, add(a, b), resource);
+        case Operator::Subtract:
+            return newLiteral(node, subtract(a, b), resource);
+        case Operator::Multiply:
+            return newLiteral(node, multiply(a, b), resource);
+        case Operator::Divide:
+            return newLiteral(node, divide(a, b), resource);
+        default:
+            return node; // left for evaluation to report
+        }
+    });
+}
+
+// A sum left with no children is a literal, and one with only a single
+// child added to nothing is that child.
+static AbstractNode *simplifySum(SumExpression *sum,
+    std::pmr::memory_resource *resource)
+{
+    if (sum->children.empty()) {
+        double value = pairwiseSum(sum->terms.data(), sum->terms.size());
+        return newLiteral(sum, Value::ofReal(value), resource);
+    }
+    if (sum->terms.empty() && sum->children.size() == 1 && sum->signs[0] > 0)
+        return sum->children[0];
+    return sum;
+}
+
+AbstractNode *Reassociation::run(AbstractNode *root,
+    std::pmr::memory_resource *resource)
+{
+    return rewriteTree(flattenSums(root, resource), [resource](AbstractNode *node) {
+        if (node->kind != NodeKind::SumExpression)
+            return node;
+        SumExpression *sum = static_cast<SumExpression *>(node);
+        if (!sum->terms.empty()) {
+            double value = pairwiseSum(sum->terms.data(), sum->terms.size());
+            sum->terms.clear();
+            if (value != 0)
+                sum->terms.push_back(value);
+        }
+        return simplifySum(sum, resource);
+    });
+}
+
+static uint64_t mix(uint64_t h, uint64_t x)
+{
+    return (h ^ x) * 0x100000001B3ULL + (h >> 29);
+}
+
+// Hash of what a node holds besides its children.
+static uint64_t nodeHash(const AbstractNode *node)
+{
+    uint64_t h = mix((uint64_t)node->kind, (uint64_t)node->op);
+    uint64_t bits;
+    switch (node->kind) {
+    case NodeKind::NumberLiteral:
+        memcpy(&bits, &node->token.value, sizeof(bits));
+        return mix(mix(h, bits), node->token.flags & Token::Integer);
+    case NodeKind::Variable:
+        return mix(h, std::hash<std::string_view>()(static_cast<const Variable *>(node)->name));
+    case NodeKind::SumExpression: {
+        const SumExpression *sum = static_cast<const SumExpression *>(node);
+        for (size_t i = 0; i < sum->terms.size(); ++i) {
+            memcpy(&bits, &sum->terms[i], sizeof(bits));
+            h = mix(h, bits);
+        }
+        for (size_t i = 0; i < sum->signs.size(); ++i)
+            h = mix(h, sum->signs[i] > 0);
+        return h;
+    }
+    default:
+        return h;
+    }
+}
+
+// True if two nodes hold the same, children aside.
+static bool sameNode(const AbstractNode *a, const AbstractNode *b)
+{
+    if (a->kind != b->kind || a->op != b->op || a->children.size() != b->children.size())
+        return false;
+    switch (a->kind) {
+    case NodeKind::NumberLiteral:
+        return (a->token.flags & Token::Integer) == (b->token.flags & Token::Integer)
+            && memcmp(&a->token.value, &b->token.value, sizeof(a->token.value)) == 0;
+    case NodeKind::Variable:
+        return static_cast<const Variable *>(a)->name == static_cast<const Variable *>(b)->name;
+    case NodeKind::SumExpression: {
+        const SumExpression *x = static_cast<const SumExpression *>(a);
+        const SumExpression *y = static_cast<const SumExpression *>(b);
+        return x->terms == y->terms && x->signs == y->signs;
+    }
+    default:
+        return true;
+    }
+}
+
+// True if two trees are the same, compared on an explicit stack.
+static bool sameTree(AbstractNode *a, AbstractNode *b)
+{
+    std::vector<std::pair<AbstractNode *, AbstractNode *>> pending;
+    pending.push_back({ a, b });
+    while (!pending.empty()) {
+        AbstractNode *x = pending.back().first;
+        AbstractNode *y = pending.back().second;
+        pending.pop_back();
+        if (!sameNode(x, y))
+            return false;
+        for (size_t i = 0; i < x->children.size(); ++i)
+            pending.push_back({ x->children[i], y->children[i] });
+    }
+    return true;
+}
+
+// Each node is hashed once, after its children, as it is rewritten; the
+// children of a sum are grouped by hash, and each group of the same tree
+// keeps as many copies as its signs do not cancel.
+AbstractNode *TermCancellation::run(AbstractNode *root,
+    std::pmr::memory_resource *resource)
+{
+    std::unordered_map<const AbstractNode *, uint64_t> hashes;
+    auto hashOf = [&hashes](AbstractNode *node) {
+        uint64_t h = nodeHash(node);
+        for (AbstractNode *child : node->children)
+            h = mix(h, hashes[child]);
+        hashes[node] = h;
+        return node;
+    };
+
+    return rewriteTree(root, [&](AbstractNode *node) {
+        if (node->kind != NodeKind::SumExpression)
+            return hashOf(node);
+
+        SumExpression *sum = static_cast<SumExpression *>(node);
+        struct Group {
+            AbstractNode *tree;
+            int count; // signs added up
+        };
+        std::vector<Group> groups;
+        std::unordered_multimap<uint64_t, size_t> byHash; // groups by tree hash
+        for (size_t i = 0; i < sum->children.size(); ++i) {
+            AbstractNode *child = sum->children[i];
+            int sign = sum->signs[i] > 0 ? 1 : -1;
+            auto range = byHash.equal_range(hashes[child]);
+            auto found = range.first;
+            while (found != range.second && !sameTree(groups[found->second].tree, child))
+                ++found;
+            if (found != range.second) {
+                groups[found->second].count += sign;
+            } else {
+                byHash.emplace(hashes[child], groups.size());
+                groups.push_back(Group{ child, sign });
+            }
+        }
+        if (groups.size() == sum->children.size())
+            return hashOf(sum);
+
+        sum->children.clear();
+        sum->signs.clear();
+        for (const Group &group : groups) {
+            for (int k = 0; k < abs(group.count); ++k) {
+                sum->addChild(group.tree);
+                sum->signs.push_back(group.count > 0 ? 1.0 : -1.0);
+            }
+        }
+        return hashOf(simplifySum(sum, resource));
+    });
+}
+
+Optimizer::Optimizer(std::pmr::memory_resource *resource, bool fastMath,
+    Arithmetic arithmetic)
+    : resource(resource)
+    , fastMath(fastMath)
+{
+    addPass(std::make_unique<ConstantFolding>(arithmetic));
+    addPass(std::make_unique<Reassociation>());
+    addPass(std::make_unique<TermCancellation>());
+}
+
+void Optimizer::addPass(std::unique_ptr<OptimizerPass> pass)
+{
+    passes.push_back(std::move(pass));
+}
+
+AbstractNode *Optimizer::optimize(AbstractNode *root)
+{
+    passReports.clear();
+    size_t nodes = countNodes(root);
+    for (const std::unique_ptr<OptimizerPass> &pass : passes) {
+        if (!pass->exact() && !fastMath) {
+            passReports.push_back(Report{ pass->name(), true, 0 });
+            continue;
+        }
+        root = pass->run(root, resource);
+        size_t after = countNodes(root);
+        passReports.push_back(Report{ pass->name(), false, nodes > after ? nodes - after : 0 });
+        nodes = after;
+    }
+    return root;
+}
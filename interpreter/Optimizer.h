@@ -0,0 +1,139 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "AbstractSyntaxTree.h"
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// A rewrite of a tree into one that evaluates the same. New nodes come
+// from resource; run() returns the new root.
+class OptimizerPass {
+public:
+    virtual ~OptimizerPass() {}
+
+    virtual const char *name() const = 0;
+
+    // True if the pass never changes a result, not even its rounding or
+    // what an infinity or NaN operand gives.
+    virtual bool exact() const = 0;
+
+    virtual AbstractNode *run(AbstractNode *root,
+        std::pmr::memory_resource *resource) = 0;
+};
+
+// The arithmetic of the evaluator a tree is optimized for: the Values of
+// the Interpreter, integers exact, or the doubles of the VM, the JIT and
+// the StaticInterpreter. They differ on integers beyond 2^53.
+enum class Arithmetic { Exact,
+    Double };
+
+// Evaluate the operators whose operands are all literals, with the
+// arithmetic of the evaluator that runs the tree.
+class ConstantFolding : public OptimizerPass {
+public:
+    explicit ConstantFolding(Arithmetic arithmetic = Arithmetic::Exact)
+        : arithmetic(arithmetic)
+    {
+    }
+
+    const char *name() const
+    {
+        return "constant folding";
+    }
+
+    bool exact() const
+    {
+        return true;
+    }
+
+    AbstractNode *run(AbstractNode *root, std::pmr::memory_resource *resource);
+
+private:
+    Arithmetic arithmetic;
+};
+
+// Flatten each '+'/'-' chain into a SumExpression and add up its literal
+// terms into one, as in x + 3 - 1 => x + 2.
+class Reassociation : public OptimizerPass {
+public:
+    const char *name() const
+    {
+        return "reassociation";
+    }
+
+    bool exact() const
+    {
+        return false;
+    }
+
+    AbstractNode *run(AbstractNode *root, std::pmr::memory_resource *resource);
+};
+
+// Drop identical terms of opposite signs from each SumExpression, as in
+// x + y - x => y; wrong when x is an infinity or NaN.
+class TermCancellation : public OptimizerPass {
+public:
+    const char *name() const
+    {
+        return "term cancellation";
+    }
+
+    bool exact() const
+    {
+        return false;
+    }
+
+    AbstractNode *run(AbstractNode *root, std::pmr::memory_resource *resource);
+};
+
+// Runs passes over a tree between parsing and evaluation. Passes that
+// are not exact only run with fastMath.
+class Optimizer {
+public:
+    // What a pass did in the latest optimize().
+    struct Report {
+        const char *pass;
+        bool skipped; // not exact and no fastMath
+        size_t removed; // nodes in the tree before less after
+    };
+
+    // With the built-in passes: folding, reassociation, cancellation,
+    // for an evaluator of the given arithmetic.
+    explicit Optimizer(std::pmr::memory_resource *resource, bool fastMath = false,
+        Arithmetic arithmetic = Arithmetic::Exact);
+
+    // Append a pass to run after the others.
+    void addPass(std::unique_ptr<OptimizerPass> pass);
+
+    // Run every pass in turn; return the new root.
+    AbstractNode *optimize(AbstractNode *root);
+
+    const std::vector<Report> &reports() const
+    {
+        return passReports;
+    }
+
+private:
+    std::pmr::memory_resource *resource; // where new nodes are allocated
+    bool fastMath; // run passes that are not exact too
+    std::vector<std::unique_ptr<OptimizerPass>> passes;
+    std::vector<Report> passReports;
+};
+
+#endif /* OPTIMIZER_H */
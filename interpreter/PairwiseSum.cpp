@@ -0,0 +1,102 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "PairwiseSum.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+// Values summed in one go before the halves are split again.
+static const size_t BlockSize = 256;
+
+// Accumulators start at -0, the identity of IEEE addition: terms that are
+// all -0 sum to -0, as a chain of additions gives.
+
+static double blockSumScalar(const double *p, size_t n)
+{
+    double acc[8] = { -0.0, -0.0, -0.0, -0.0, -0.0, -0.0, -0.0, -0.0 };
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        for (int k = 0; k < 8; ++k)
+            acc[k] += p[i + k];
+    for (int k = 0; i < n; ++i, ++k)
+        acc[k] += p[i];
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+#ifdef HAVE_X86_SIMD
+
+static double blockSumSse2(const double *p, size_t n)
+{
+    __m128d a0 = _mm_set1_pd(-0.0), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(p + i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(p + i + 2));
+        a2 = _mm_add_pd(a2, _mm_loadu_pd(p + i + 4));
+        a3 = _mm_add_pd(a3, _mm_loadu_pd(p + i + 6));
+    }
+    __m128d a = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3));
+    double lanes[2];
+    _mm_storeu_pd(lanes, a);
+    return (lanes[0] + lanes[1]) + blockSumScalar(p + i, n - i);
+}
+
+__attribute__((target("avx2"))) static double blockSumAvx2(const double *p, size_t n)
+{
+    __m256d a0 = _mm256_set1_pd(-0.0), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(p + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(p + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(p + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(p + i + 12));
+    }
+    __m256d a = _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3));
+    __m128d b = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    double lanes[2];
+    _mm_storeu_pd(lanes, b);
+    return (lanes[0] + lanes[1]) + blockSumScalar(p + i, n - i);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+typedef double (*BlockSumFunction)(const double *, size_t);
+
+// Pick the widest implementation the running CPU supports.
+static BlockSumFunction selectBlockSum()
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return blockSumAvx2;
+    return blockSumSse2;
+#else
+    return blockSumScalar;
+#endif
+}
+
+static const BlockSumFunction blockSum = selectBlockSum();
+
+double pairwiseSum(const double *values, size_t n)
+{
+    if (n <= BlockSize)
+        return blockSum(values, n);
+    // split on a block boundary, so that blocks stay whole
+    size_t half = (n / 2 + BlockSize - 1) / BlockSize * BlockSize;
+    return pairwiseSum(values, half) + pairwiseSum(values + half, n - half);
+}
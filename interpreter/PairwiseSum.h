@@ -0,0 +1,28 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PAIRWISE_SUM_H
+#define PAIRWISE_SUM_H
+
+#include <stddef.h>
+
+// Sum of n doubles by pairwise summation: blocks of values are summed
+// with several independent accumulators (AVX2 or SSE2 lanes when the
+// CPU has them), and block sums are added in a balanced tree. The
+// rounding error grows with log(n) rather than n, and the additions of
+// a block do not wait on each other.
+double pairwiseSum(const double *values, size_t n);
+
+#endif /* PAIRWISE_SUM_H */
@@ -14,35 +14,225 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Parser.h"
-#include <iostream>
+#include "ExpressionBuilder.h"
+#include "Trace.h"
 
-std::shared_ptr<AbstractNode> Parser::number()
+template <class TokenScanner>
+AbstractNode *Parser<TokenScanner>::number()
 {
-    auto token = currentToken();
-    if (match(token, Token::Number))
-        return std::make_shared<NumberLiteral>(token);
-    else
-        throw "SyntaxError: number is expected!";
+    Token token = currentToken();
+    if (!match(token, Token::Number))
+        throw errorMessage(unexpected(token, NumberExpected));
+    return newNode<NumberLiteral>(resource, token);
 }
 
-std::shared_ptr<AbstractNode> Parser::expression()
+template <class TokenScanner>
+AbstractNode *Parser<TokenScanner>::expression()
 {
-    auto root = number();
+    return tryExpression().valueOrThrow();
+}
+
+template <class TokenScanner>
+void Parser<TokenScanner>::expression(FlatTree *tree)
+{
+    tryExpression(tree).valueOrThrow();
+}
+
+template <class TokenScanner>
+Value Parser<TokenScanner>::evaluate()
+{
+    return tryEvaluate().valueOrThrow();
+}
+
+template <class TokenScanner>
+Result<AbstractNode *> Parser<TokenScanner>::tryExpression()
+{
+    TreeBuilder builder(resource);
+    return parse(&builder);
+}
+
+template <class TokenScanner>
+Result<uint32_t> Parser<TokenScanner>::tryExpression(FlatTree *tree)
+{
+    tree->clear();
+    FlatTreeBuilder builder(tree);
+    return parse(&builder);
+}
+
+template <class TokenScanner>
+Result<Value> Parser<TokenScanner>::tryEvaluate()
+{
+    ValueBuilder builder;
+    return parse(&builder);
+}
 
-    while (currentToken()->type == Token::Plus || currentToken()->type == Token::Minus) {
-        auto token = currentToken();
+template <class TokenScanner>
+template <class Builder>
+Result<typename Builder::Node> Parser<TokenScanner>::parse(Builder *builder)
+{
+    [[maybe_unused]] size_t start = currentToken().offset; // only traced
+    std::vector<typename Builder::Node> operands;
+    operators.clear();
+
+    for (;;) {
+        // an operand: any prefix operators and '(', then a number or a
+        // variable
+        for (;;) {
+            const Token &token = currentToken();
+            if (token.type == Token::Minus)
+                operators.push_back(Pending{ token, Prefix });
+            else if (token.type == Token::LeftParen)
+                operators.push_back(Pending{ token, Parenthesis });
+            else
+                break;
+            nextToken();
+        }
+        const Token &token = currentToken();
+        if (token.type == Token::Number) {
+            operands.push_back(builder->number(token));
+        } else if (token.type != Token::Identifier) {
+            return Error{ unexpected(token, NumberExpected), token.offset };
+        } else if constexpr (Builder::variables) {
+            operands.push_back(builder->variable(token, scanner->textOf(token)));
+        } else {
+            return Error{ UnknownVariable, token.offset };
+        }
         nextToken();
-        auto lhs = root;
-        auto rhs = number();
-        root = std::make_shared<BinaryExpression>(token);
-        root->addChild(lhs);
-        root->addChild(rhs);
+
+        // then any ')', and the binary operator before the next operand;
+        // precedence is left at Parenthesis when the expression ends
+        int precedence = Parenthesis;
+        for (;;) {
+            const Token &token = currentToken();
+            if (token.type == Token::Plus || token.type == Token::Minus)
+                precedence = Additive;
+            else if (token.type == Token::Star || token.type == Token::Slash)
+                precedence = Multiplicative;
+            else if (token.type == Token::RightParen)
+                precedence = Parenthesis;
+            else
+                break;
+
+            while (!operators.empty() && operators.back().precedence >= precedence
+                && operators.back().precedence != Parenthesis)
+                reduce(builder, &operands);
+
+            if (precedence != Parenthesis)
+                break;
+            if (operators.empty())
+                return Error{ UnexpectedParenthesis, token.offset };
+            operators.pop_back();
+            nextToken();
+        }
+        if (precedence == Parenthesis)
+            break;
+
+        operators.push_back(Pending{ currentToken(), precedence });
+        nextToken();
+    }
+
+    while (!operators.empty()) {
+        if (operators.back().precedence == Parenthesis)
+            return Error{ unexpected(currentToken(), ParenthesisExpected), currentToken().offset };
+        reduce(builder, &operands);
     }
 
-    if (currentToken()->type == EOF)
-        printf("Accepted!\n");
-    else
-        throw "SyntaxError: unexpected token!";
+    if (currentToken().type != EOF)
+        return Error{ unexpected(currentToken(), UnexpectedToken), currentToken().offset };
+    if (builder->error.code != Ok)
+        return builder->error;
 
-    return root;
+    TRACE_INFO(AcceptExpression, start, currentToken().offset - start);
+
+    return operands.back();
 }
+
+template <class TokenScanner>
+template <class Builder>
+void Parser<TokenScanner>::reduce(Builder *builder,
+    std::vector<typename Builder::Node> *operands)
+{
+    Pending op = operators.back();
+    operators.pop_back();
+
+    typename Builder::Node rhs = operands->back();
+    if (op.precedence == Prefix) {
+        operands->back() = builder->unary(op.token, rhs);
+    } else {
+        operands->pop_back();
+        operands->back() = builder->binary(op.token, operands->back(), rhs);
+    }
+}
+
+template <class TokenScanner>
+size_t Parser<TokenScanner>::check(std::vector<Diagnostic> *diagnostics)
+{
+    size_t lines = 0;
+    const Token *token = &currentToken();
+    while (token->type != EOF) {
+        ++lines;
+        bool expectOperand = true;
+        bool failed = false;
+        size_t depth = 0;
+        size_t end = token->offset; // end of the latest token on the line
+        do {
+            if (ErrorCode error = checkToken(*token, &expectOperand, &depth)) {
+                diagnostics->push_back(Diagnostic{ token->offset, error });
+                failed = true;
+
+                // resume after the next operator, if the line has one
+                bool resync = isOperator(token->type);
+                while (!resync) {
+                    token = &scanner->nextToken();
+                    if (endsLine(*token))
+                        break;
+                    resync = isOperator(token->type);
+                }
+                if (!resync)
+                    continue;
+                expectOperand = true;
+            }
+            end = token->offset + token->length;
+            token = &scanner->nextToken();
+        } while (!endsLine(*token));
+
+        // a line cut short is only worth reporting if nothing else was
+        if (!failed && expectOperand)
+            diagnostics->push_back(Diagnostic{ end, NumberExpected });
+        else if (!failed && depth)
+            diagnostics->push_back(Diagnostic{ end, ParenthesisExpected });
+    }
+    return lines;
+}
+
+template <class TokenScanner>
+ErrorCode Parser<TokenScanner>::checkToken(const Token &token,
+    bool *expectOperand, size_t *depth)
+{
+    if (token.type == Token::Invalid)
+        return InvalidToken;
+
+    if (*expectOperand) {
+        if (token.type == Token::Number || token.type == Token::Identifier)
+            *expectOperand = false;
+        else if (token.type == Token::LeftParen)
+            ++*depth;
+        else if (token.type != Token::Minus)
+            return NumberExpected;
+    } else {
+        if (isOperator(token.type))
+            *expectOperand = true;
+        else if (token.type != Token::RightParen)
+            return UnexpectedToken;
+        else if (*depth)
+            --*depth;
+        else
+            return UnexpectedParenthesis;
+    }
+    return Ok;
+}
+
+template class Parser<Scanner<CharStream>>;
+template class Parser<Scanner<SpanSource>>;
+template class Parser<Scanner<SentinelSource>>;
+template class Parser<TableScanner>;
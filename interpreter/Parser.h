@@ -17,38 +17,147 @@
 #define PARSER_H
 
 #include "AbstractSyntaxTree.h"
+#include "FlatTree.h"
+#include "Result.h"
 #include "Scanner.h"
+#include "TableScanner.h"
+#include "Value.h"
+#include <memory_resource>
+#include <vector>
 
+// An error found while checking: where and what.
+struct Diagnostic {
+    size_t offset; // source offset of the offending token
+    ErrorCode code;
+};
+
+// Parser over any scanner handing out Tokens: Scanner<Source> for each
+// character source, or TableScanner. It recognizes
+//     expression ::= term ( ( '+' | '-' ) term )*
+//     term       ::= factor ( ( '*' | '/' ) factor )*
+//     factor     ::= '-' factor | '(' expression ')' | number | identifier
+// by operator precedence, keeping pending operators and operands on
+// explicit stacks rather than the C++ call stack, so nesting depth is
+// bounded by memory only.
+template <class TokenScanner>
 class Parser {
 public:
-    explicit Parser(Scanner *scanner)
+    // Nodes are allocated from resource, or from the parser's own arena
+    // when none is given; they live as long as that memory.
+    explicit Parser(TokenScanner *scanner,
+                    std::pmr::memory_resource *resource = nullptr)
         : scanner(scanner)
+        , arena(buffer, sizeof(buffer))
+        , resource(resource ? resource : &arena)
+    {
+    }
+
+    Parser(const Parser &) = delete;
+    Parser &operator=(const Parser &) = delete;
+
+    AbstractNode *expression();
+    AbstractNode *number();
+
+    // Parse the same grammar into a flat post-order tree instead.
+    void expression(FlatTree *tree);
+
+    // Evaluate the expression while parsing it, building no tree; the
+    // result is the same as evaluating expression().
+    Value evaluate();
+
+    // The same without exceptions: errors come back in the Result, and
+    // the methods above merely throw their message.
+    Result<AbstractNode *> tryExpression();
+    Result<uint32_t> tryExpression(FlatTree *tree);
+    Result<Value> tryEvaluate();
+
+    // Check the input as one expression per line, collecting every error
+    // instead of stopping at the first: after an error the rest of the
+    // line is skipped up to the next operator (panic mode). Return the
+    // number of expressions checked.
+    size_t check(std::vector<Diagnostic> *diagnostics);
+
+    // Where nodes are allocated, for passes that add nodes to a tree.
+    std::pmr::memory_resource *memoryResource() const
     {
+        return resource;
     }
 
-    std::shared_ptr<AbstractNode> expression();
-    std::shared_ptr<AbstractNode> number();
+    // Free every node parsed so far from the parser's own arena at once.
+    void release()
+    {
+        arena.release();
+    }
 
 private:
-    std::shared_ptr<Token> currentToken() const
+    const Token &currentToken() const
     {
         return scanner->currentToken();
     }
 
-    std::shared_ptr<Token> nextToken()
+    const Token &nextToken()
     {
         return scanner->nextToken();
     }
 
-    bool match(std::shared_ptr<Token> token, int type)
+    bool match(const Token &token, int type)
     {
-        if (token->type != type)
+        if (token.type != type)
             return false;
         nextToken();
         return true;
     }
 
-    Scanner *scanner; // from where we get tokens
+    // A pending operator, or a '(' with the lowest precedence.
+    struct Pending {
+        Token token;
+        int precedence;
+    };
+
+    enum Precedence { Parenthesis,
+        Additive,
+        Multiplicative,
+        Prefix };
+
+    // Parse a whole expression with a builder; return its root.
+    template <class Builder>
+    Result<typename Builder::Node> parse(Builder *builder);
+
+    // Build the pending operator on top of the stack from its operands.
+    template <class Builder>
+    void reduce(Builder *builder, std::vector<typename Builder::Node> *operands);
+
+    // Error of a token in a line being checked, or Ok
+    static ErrorCode checkToken(const Token &token, bool *expectOperand,
+        size_t *depth);
+
+    static bool isOperator(int type)
+    {
+        return type == Token::Plus || type == Token::Minus
+            || type == Token::Star || type == Token::Slash;
+    }
+
+    static bool endsLine(const Token &token)
+    {
+        return token.type == EOF || (token.flags & Token::LineStart);
+    }
+
+    // Error of a token where an operand or an operator should be
+    static ErrorCode unexpected(const Token &token, ErrorCode code)
+    {
+        return token.type == Token::Invalid ? InvalidToken : code;
+    }
+
+    TokenScanner *scanner; // from where we get tokens
+    alignas(std::max_align_t) char buffer[1024]; // first arena block
+    std::pmr::monotonic_buffer_resource arena; // default node memory
+    std::pmr::memory_resource *resource; // where nodes are allocated
+    std::vector<Pending> operators; // operators waiting for operands
 };
 
+extern template class Parser<Scanner<CharStream>>;
+extern template class Parser<Scanner<SpanSource>>;
+extern template class Parser<Scanner<SentinelSource>>;
+extern template class Parser<TableScanner>;
+
 #endif /* PARSER_H */
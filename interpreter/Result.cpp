@@ -0,0 +1,39 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Result.h"
+
+const char *errorMessage(ErrorCode code)
+{
+    switch (code) {
+    case Ok:
+        return "OK";
+    case InvalidToken:
+        return "Invalid token!";
+    case NumberExpected:
+        return "SyntaxError: number is expected!";
+    case UnexpectedToken:
+        return "SyntaxError: unexpected token!";
+    case UnexpectedParenthesis:
+        return "SyntaxError: unexpected ')'!";
+    case ParenthesisExpected:
+        return "SyntaxError: ')' is expected!";
+    case UndefinedOperation:
+        return "Undefined operation!";
+    case UnknownVariable:
+        return "Unknown variable!";
+    }
+    return "Unknown error!";
+}
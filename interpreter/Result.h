@@ -0,0 +1,96 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RESULT_H
+#define RESULT_H
+
+#include <stddef.h>
+
+// What went wrong, for the non-throwing API.
+enum ErrorCode {
+    Ok,
+    InvalidToken,
+    NumberExpected,
+    UnexpectedToken,
+    UnexpectedParenthesis,
+    ParenthesisExpected,
+    UndefinedOperation,
+    UnknownVariable
+};
+
+// The message the throwing API raises for an error code.
+const char *errorMessage(ErrorCode code);
+
+// An error and the source offset it was found at.
+struct Error {
+    ErrorCode code;
+    size_t offset;
+};
+
+// Either a value or an Error, returned instead of throwing.
+template <class T>
+class Result {
+public:
+    Result(const T &value)
+        : error{ Ok, 0 }
+        , result(value)
+    {
+    }
+
+    Result(const Error &error)
+        : error(error)
+        , result()
+    {
+    }
+
+    bool ok() const
+    {
+        return error.code == Ok;
+    }
+
+    ErrorCode code() const
+    {
+        return error.code;
+    }
+
+    size_t offset() const
+    {
+        return error.offset;
+    }
+
+    const char *message() const
+    {
+        return errorMessage(error.code);
+    }
+
+    const T &value() const
+    {
+        return result;
+    }
+
+    // Bridge to the throwing API.
+    const T &valueOrThrow() const
+    {
+        if (!ok())
+            throw errorMessage(error.code);
+        return result;
+    }
+
+private:
+    Error error;
+    T result;
+};
+
+#endif /* RESULT_H */
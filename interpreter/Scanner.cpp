@@ -14,24 +14,40 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Scanner.h"
-#include <iostream>
+#include "NumberParser.h"
+#include "Trace.h"
 
-std::shared_ptr<Token> Scanner::nextToken()
+template <class Source>
+const Token &Scanner<Source>::nextToken()
 {
-    skipWhiteSpace();
-    initToken();
+    bool newline = skipWhiteSpace();
+    initToken(newline || charStream->currentOffset() == 0);
 
     char ch;
-    if ((ch = currentChar()) != EOF) {
+    if ((ch = currentChar()) != Source::eof) {
         switch (ch) {
         case '+':
             setType(Token::Plus);
-            enterChar();
             nextChar();
             break;
         case '-':
             setType(Token::Minus);
-            enterChar();
+            nextChar();
+            break;
+        case '*':
+            setType(Token::Star);
+            nextChar();
+            break;
+        case '/':
+            setType(Token::Slash);
+            nextChar();
+            break;
+        case '(':
+            setType(Token::LeftParen);
+            nextChar();
+            break;
+        case ')':
+            setType(Token::RightParen);
             nextChar();
             break;
         case '0':
@@ -45,96 +61,164 @@ std::shared_ptr<Token> Scanner::nextToken()
         case '8':
         case '9':
         case '.':
-            numberLiteral();
+            if (!numberLiteral())
+                setType(Token::Invalid);
+            else if (integral && digits <= maxMantissaDigits && mantissa <= INT64_MAX)
+                setInteger((int64_t)mantissa);
+            else
+                token.value = numberValue();
             break;
         default:
-            throw "Invalid character!";
+            if (isalpha((unsigned char)ch) || ch == '_') {
+                identifier();
+                break;
+            }
+            // left to the parser to report, so that it may go on
+            setType(Token::Invalid);
+            nextChar();
+            break;
         }
     } else {
         setType(EOF);
-        setText("EOF");
     }
-    std::cout << ".. Scanning token: " << token->text
-              << ", type: " << token->type << std::endl;
-    return token;
-}
+    token.length = charStream->currentOffset() - token.offset;
 
-void Scanner::initToken()
-{
-    token = std::make_shared<Token>("",
-        charStream->currentRow(),
-        charStream->currentColumn(),
-        Token::None);
+    TRACE_DEBUG(ScanToken, token.type, token.offset);
+    return token;
 }
 
-void Scanner::enterChar()
+template <class Source>
+void Scanner<Source>::initToken(bool lineStart)
 {
-    token->text.append(1, currentChar());
+    charStream->mark();
+    token = Token(Token::None, charStream->currentOffset(), 0);
+    token.flags = lineStart ? Token::LineStart : 0;
 }
 
-// Set current token text
-void Scanner::setText(std::string text)
+// Set current token type
+template <class Source>
+void Scanner<Source>::setType(int type)
 {
-    token->text = text;
+    token.type = type;
 }
 
-// Set current token type
-void Scanner::setType(int type)
+// Give the current Number an exact integer value
+template <class Source>
+void Scanner<Source>::setInteger(int64_t value)
 {
-    token->type = type;
+    token.flags |= Token::Integer;
+    token.integer = value;
 }
 
-// Scanning unsigned integer
+// Scanning unsigned integer, accumulating its digits into the mantissa
+// (digits of a fraction also scale the exponent down)
 // Return true on success, otherwise, return false
-bool Scanner::integerLiteral()
+template <class Source>
+bool Scanner<Source>::integerLiteral(bool fraction)
 {
     if (!isdigit(currentChar()))
         return false;
 
-    while (isdigit(currentChar())) {
-        enterChar();
+    // eight digits at a time while they are in memory and fit the mantissa
+    uint64_t chunk;
+    while (digits + 8 <= maxMantissaDigits && charStream->available() >= 8
+        && loadEightDigits(charStream->current(), &chunk)) {
+        mantissa = mantissa * 100000000 + parseEightDigits(chunk);
+        digits += 8;
+        exponent -= fraction ? 8 : 0;
+        charStream->skip(8);
+    }
+
+    char ch;
+    while (isdigit(ch = currentChar())) {
+        if (mantissa != 0 || ch != '0')
+            ++digits;
+        mantissa = mantissa * 10 + (ch - '0');
+        exponent -= fraction ? 1 : 0;
         nextChar();
     }
     return true;
 }
 
+// Scanning identifier:
+// identifier ::= ( letter | '_' ) ( letter | digit | '_' )*
+template <class Source>
+void Scanner<Source>::identifier()
+{
+    setType(Token::Identifier);
+    char ch;
+    do {
+        nextChar();
+        ch = currentChar();
+    } while (isalnum((unsigned char)ch) || ch == '_');
+}
+
 // Scanning unsigned number:
 // number ::= ( integer ( '.' integer? )? | '.' integer ) ( ( 'e' | 'E' ) ( '+' | '-' )? integer )?
 // Return true on success, otherwise, return false
-bool Scanner::numberLiteral()
+template <class Source>
+bool Scanner<Source>::numberLiteral()
 {
     setType(Token::Number); /* default type */
+    integral = true;
+    mantissa = 0;
+    exponent = 0;
+    digits = 0;
 
     if (isdigit(currentChar())) {
-        integerLiteral();
+        integerLiteral(false);
         if (currentChar() == '.') {
-            //setType(Float);
-            enterChar();
+            integral = false;
             nextChar();
             if (isdigit(currentChar())) {
-                integerLiteral();
+                integerLiteral(true);
             }
         }
     } else if (currentChar() == '.') {
-        //setType(Float);
-        enterChar();
+        integral = false;
         nextChar();
-        if (!integerLiteral())
+        if (!integerLiteral(true))
             return false;
     } else
         return false;
 
     if (currentChar() == 'e' || currentChar() == 'E') {
-        //setType(Float);
-        enterChar();
+        integral = false;
         nextChar();
+        bool negative = currentChar() == '-';
         if (currentChar() == '+' || currentChar() == '-') {
-            enterChar();
             nextChar();
         }
-        if (!integerLiteral())
+        if (!isdigit(currentChar()))
             return false;
+
+        int64_t e = 0;
+        char ch;
+        while (isdigit(ch = currentChar())) {
+            if (e < 100000) // far beyond the range of double
+                e = e * 10 + (ch - '0');
+            nextChar();
+        }
+        exponent += negative ? -e : e;
     }
 
     return true;
 }
+
+// The value is composed from the digits gathered while scanning; only a
+// mantissa too long for 64 bits or an undecidable rounding falls back to
+// converting the text again.
+template <class Source>
+double Scanner<Source>::numberValue() const
+{
+    double value;
+    if (digits <= maxMantissaDigits && composeNumber(mantissa, exponent, &value))
+        return value;
+
+    size_t start = token.offset;
+    return decodeNumberExact(charStream->textAt(start), charStream->currentOffset() - start);
+}
+
+template class Scanner<CharStream>;
+template class Scanner<SpanSource>;
+template class Scanner<SentinelSource>;
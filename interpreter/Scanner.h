@@ -17,23 +17,35 @@
 #define SCANNER_H
 
 #include "CharStream.h"
+#include "SourcePolicies.h"
 #include "Token.h"
-#include <memory>
+#include <stdint.h>
 
+// Scanner over a character source policy: CharStream, SpanSource or
+// SentinelSource (see SourcePolicies.h). Each instantiation reads
+// characters through the policy's inline methods.
+template <class Source>
 class Scanner {
 public:
-    explicit Scanner(CharStream *charStream)
+    explicit Scanner(Source *charStream)
         : charStream(charStream)
     {
         nextToken();
     }
 
-    std::shared_ptr<Token> currentToken() const
+    const Token &currentToken() const
     {
         return token;
     }
 
-    std::shared_ptr<Token> nextToken();
+    const Token &nextToken();
+
+    // The text of a token, valid while it is the current one (a streamed
+    // source keeps no more than that).
+    const char *textOf(const Token &token) const
+    {
+        return charStream->textAt(token.offset);
+    }
 
     // Call charStream's currentChar() method
     char currentChar() const
@@ -52,28 +64,46 @@ public:
         return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
     }
 
-    void skipWhiteSpace()
+    // Return true if a newline was skipped. The mark follows, so that a
+    // streamed source need not keep the blanks.
+    bool skipWhiteSpace()
     {
-        while (isWhiteSpace(currentChar()))
+        bool newline = false;
+        char ch;
+        while (isWhiteSpace(ch = currentChar())) {
+            newline |= ch == '\n';
+            charStream->mark();
             nextChar();
+        }
+        return newline;
     }
 
 private:
-    // Initialize token pointer
-    void initToken();
-    // Set current token's text
-    void setText(std::string text);
+    // Start a new token at the current position
+    void initToken(bool lineStart);
     // Set current token's type
     void setType(int type);
-    // Append current char to current token's text
-    void enterChar();
+    // Set current token's exact integer value
+    void setInteger(int64_t value);
     // Scanning unsigned integer literal
-    bool integerLiteral();
+    bool integerLiteral(bool fraction);
     // Scanning unsigned number literal
     bool numberLiteral();
+    // Scanning identifier
+    void identifier();
+    // Value of the number literal just scanned
+    double numberValue() const;
 
-    CharStream *charStream; // source code
-    std::shared_ptr<Token> token; // current token
+    Source *charStream; // source code
+    Token token; // current token
+    uint64_t mantissa; // digits of the number being scanned
+    int64_t exponent; // its decimal exponent
+    int digits; // its significant digits, beyond 19 mantissa is inexact
+    bool integral; // no fraction or exponent so far
 };
 
+extern template class Scanner<CharStream>;
+extern template class Scanner<SpanSource>;
+extern template class Scanner<SentinelSource>;
+
 #endif /* SCANNER_H */
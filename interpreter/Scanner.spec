@@ -0,0 +1,24 @@
+############################################################
+# Scanner specification
+# tools/ScannerGenerator turns these rules into the dense DFA
+# tables of ScannerTable.h, used by TableScanner.
+#
+# One rule per line:    name    regular-expression
+#
+# The name is a Token type (Token::<name>), or 'skip' for text
+# that separates tokens. When several rules match the same
+# longest text, the rule listed first wins.
+#
+# Expressions: 'text' literal, [a-z] character class,
+# ( ) grouping, | alternation, * + ? repetition.
+############################################################
+
+skip    [ \t\r\n]+
+Plus    '+'
+Minus   '-'
+Star    '*'
+Slash   '/'
+LeftParen   '('
+RightParen  ')'
+Number  ( [0-9]+ ( '.' [0-9]* )? | '.' [0-9]+ ) ( [eE] [+-]? [0-9]+ )?
+Identifier  [a-zA-Z_] [a-zA-Z0-9_]*
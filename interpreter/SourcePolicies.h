@@ -0,0 +1,150 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SOURCE_POLICIES_H
+#define SOURCE_POLICIES_H
+
+#include "LineIndex.h"
+#include <stddef.h>
+#include <stdio.h>
+
+// Character sources for Scanner<Source> besides CharStream. A source
+// provides, all inline:
+//     currentChar(), nextChar()      the character at / after the position
+//     eof                            what currentChar() returns at the end
+//     currentOffset(), textAt()      positions and the text behind them
+//     mark(), markedOffset()         start of the token being scanned
+//     current(), available(), skip() bulk access to in-memory characters
+//     locate()                       line and column of an offset
+// CharStream itself is the source for stdin, streams and the REPL.
+
+// What the sources over a buffer in memory share: everything but
+// reading the current character, which is where they differ.
+class MemorySource {
+public:
+    size_t currentOffset() const
+    {
+        return position - begin;
+    }
+
+    const char *textAt(size_t offset) const
+    {
+        return offset <= (size_t)(end - begin) ? begin + offset : nullptr;
+    }
+
+    void mark()
+    {
+        marked = position;
+    }
+
+    size_t markedOffset() const
+    {
+        return marked - begin;
+    }
+
+    const char *current() const
+    {
+        return position;
+    }
+
+    size_t available() const
+    {
+        return end - position;
+    }
+
+    void skip(size_t n)
+    {
+        position += n;
+    }
+
+    // Line and column (both from 1) of an offset; only for diagnostics,
+    // the line index is built on the first call.
+    void locate(size_t offset, size_t *row, size_t *column)
+    {
+        if (!indexed) {
+            lines.scan(begin, end - begin, 0);
+            indexed = true;
+        }
+        lines.locate(offset, row, column);
+    }
+
+protected:
+    MemorySource(const char *data, size_t length)
+        : begin(data)
+        , end(data + length)
+        , position(data)
+        , marked(data)
+        , indexed(false)
+    {
+    }
+
+    const char *begin; // first character
+    const char *end; // one past the last character
+    const char *position; // current character
+    const char *marked; // start of the latest token
+
+private:
+    LineIndex lines; // line starts, built on the first locate()
+    bool indexed; // true once lines covers the buffer
+};
+
+// Characters of a buffer in memory (e.g. a MappedFile), bounds-checked
+// inline without any refill hook.
+class SpanSource : public MemorySource {
+public:
+    static const char eof = EOF;
+
+    SpanSource(const char *data, size_t length)
+        : MemorySource(data, length)
+    {
+    }
+
+    char currentChar() const
+    {
+        return position < end ? *position : eof;
+    }
+
+    char nextChar()
+    {
+        ++position;
+        return currentChar();
+    }
+};
+
+// Characters of a null-terminated buffer (e.g. std::string::c_str()).
+// The terminator stops every scanning loop by itself, as no token
+// contains it, so characters are read with no bounds check at all.
+class SentinelSource : public MemorySource {
+public:
+    static const char eof = '\0';
+
+    // data[length] must be '\0'
+    SentinelSource(const char *data, size_t length)
+        : MemorySource(data, length)
+    {
+    }
+
+    char currentChar() const
+    {
+        return *position;
+    }
+
+    char nextChar()
+    {
+        return *++position;
+    }
+};
+
+#endif /* SOURCE_POLICIES_H */
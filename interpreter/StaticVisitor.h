@@ -0,0 +1,121 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATIC_VISITOR_H
+#define STATIC_VISITOR_H
+
+#include "AbstractSyntaxTree.h"
+#include "PairwiseSum.h"
+#include "TreeWalker.h"
+#include <math.h>
+#include <vector>
+
+// Visitor dispatched at compile time: dispatch() switches on the node
+// kind and calls Derived::visit() for the concrete class directly, so
+// the compiler can inline the whole traversal. Derived must have a
+// visit(node, operands) for each class of AST_NODE_LIST, returning R
+// from operands, the results of the node's children. The tree is walked
+// on an explicit stack, so its depth costs no C++ stack.
+template <class Derived, class R>
+class StaticVisitor {
+public:
+    R dispatch(AbstractNode *root)
+    {
+        size_t base = results.size();
+        walkTree(root, [this](AbstractNode *node, size_t done) {
+            size_t n = node->children.size();
+            if (done < n)
+                return;
+            R *operands = results.data() + results.size() - n;
+            R result = visit(node, operands);
+            results.resize(results.size() - n);
+            results.push_back(result);
+        });
+        R result = results.back();
+        results.resize(base);
+        return result;
+    }
+
+private:
+    R visit(AbstractNode *node, R *operands)
+    {
+#define AST_NODE_CASE(classname) \
+    case NodeKind::classname:    \
+        return derived()->visit(static_cast<classname *>(node), operands);
+
+        switch (node->kind) {
+            AST_NODE_LIST(AST_NODE_CASE)
+        }
+#undef AST_NODE_CASE
+        __builtin_unreachable();
+    }
+
+    Derived *derived()
+    {
+        return static_cast<Derived *>(this);
+    }
+
+    std::vector<R> results; // stack of the children's results
+};
+
+// Interpreter over StaticVisitor; an undefined operation or a variable
+// gives NaN.
+class StaticInterpreter : public StaticVisitor<StaticInterpreter, double> {
+public:
+    double visit(BinaryExpression *binexp, double *operands)
+    {
+        double a = operands[0];
+        double b = operands[1];
+
+        switch (binexp->op) {
+        case Operator::Add:
+            return a + b;
+        case Operator::Subtract:
+            return a - b;
+        case Operator::Multiply:
+            return a * b;
+        case Operator::Divide:
+            return a / b;
+        default:
+            return NAN;
+        }
+    }
+
+    double visit(UnaryExpression *unexp, double *operands)
+    {
+        return unexp->op == Operator::Negate ? -operands[0] : NAN;
+    }
+
+    double visit(NumberLiteral *number, double *)
+    {
+        return number->token.number();
+    }
+
+    double visit(SumExpression *sum, double *operands)
+    {
+        size_t n = sum->children.size();
+        for (size_t i = 0; i < n; ++i)
+            operands[i] *= sum->signs[i];
+        return pairwiseSum(sum->terms.data(), sum->terms.size())
+            + pairwiseSum(operands, n);
+    }
+
+    double visit(Variable *, double *)
+    {
+        return NAN;
+    }
+};
+
+#endif /* STATIC_VISITOR_H */
@@ -0,0 +1,589 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "StructuralIndexer.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+typedef StructuralIndexer::Block Block;
+
+#ifdef HAVE_X86_SIMD
+
+static inline void classifySse2(const char *p, Block *block)
+{
+    Block result = {};
+    for (int k = 0; k < 4; ++k) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+        __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+        __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+        __m128i minus = _mm_cmpeq_epi8(x, _mm_set1_epi8('-'));
+        __m128i sign = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('+')), minus);
+        __m128i product = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('*')),
+            _mm_cmpeq_epi8(x, _mm_set1_epi8('/')));
+        __m128i open = _mm_cmpeq_epi8(x, _mm_set1_epi8('('));
+        __m128i close = _mm_cmpeq_epi8(x, _mm_set1_epi8(')'));
+        __m128i dot = _mm_cmpeq_epi8(x, _mm_set1_epi8('.'));
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        __m128i exponent = _mm_cmpeq_epi8(lower, _mm_set1_epi8('e'));
+        __m128i l = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+        __m128i letter = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(25)), l),
+            _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\t')),
+                _mm_cmpeq_epi8(x, _mm_set1_epi8('\r'))));
+        __m128i newline = _mm_cmpeq_epi8(x, _mm_set1_epi8('\n'));
+
+        int shift = 16 * k;
+        result.digit |= (uint64_t)(uint16_t)_mm_movemask_epi8(digit) << shift;
+        result.sign |= (uint64_t)(uint16_t)_mm_movemask_epi8(sign) << shift;
+        result.minus |= (uint64_t)(uint16_t)_mm_movemask_epi8(minus) << shift;
+        result.product |= (uint64_t)(uint16_t)_mm_movemask_epi8(product) << shift;
+        result.open |= (uint64_t)(uint16_t)_mm_movemask_epi8(open) << shift;
+        result.close |= (uint64_t)(uint16_t)_mm_movemask_epi8(close) << shift;
+        result.dot |= (uint64_t)(uint16_t)_mm_movemask_epi8(dot) << shift;
+        result.exponent |= (uint64_t)(uint16_t)_mm_movemask_epi8(exponent) << shift;
+        result.letter |= (uint64_t)(uint16_t)_mm_movemask_epi8(letter) << shift;
+        result.space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << shift;
+        result.newline |= (uint64_t)(uint16_t)_mm_movemask_epi8(newline) << shift;
+    }
+    result.other = ~(result.digit | result.sign | result.product | result.open
+        | result.close | result.dot | result.letter | result.space | result.newline);
+    *block = result;
+}
+
+__attribute__((target("avx2"))) static inline void classifyAvx2(const char *p, Block *block)
+{
+    Block result = {};
+    for (int k = 0; k < 2; ++k) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(p + 32 * k));
+        __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+        __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+        __m256i minus = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('-'));
+        __m256i sign = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('+')), minus);
+        __m256i product = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('*')),
+            _mm256_cmpeq_epi8(x, _mm256_set1_epi8('/')));
+        __m256i open = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('('));
+        __m256i close = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')'));
+        __m256i dot = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('.'));
+        __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        __m256i exponent = _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('e'));
+        __m256i l = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+        __m256i letter = _mm256_or_si256(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(25)), l),
+            _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')),
+                _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r'))));
+        __m256i newline = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'));
+
+        int shift = 32 * k;
+        result.digit |= (uint64_t)(uint32_t)_mm256_movemask_epi8(digit) << shift;
+        result.sign |= (uint64_t)(uint32_t)_mm256_movemask_epi8(sign) << shift;
+        result.minus |= (uint64_t)(uint32_t)_mm256_movemask_epi8(minus) << shift;
+        result.product |= (uint64_t)(uint32_t)_mm256_movemask_epi8(product) << shift;
+        result.open |= (uint64_t)(uint32_t)_mm256_movemask_epi8(open) << shift;
+        result.close |= (uint64_t)(uint32_t)_mm256_movemask_epi8(close) << shift;
+        result.dot |= (uint64_t)(uint32_t)_mm256_movemask_epi8(dot) << shift;
+        result.exponent |= (uint64_t)(uint32_t)_mm256_movemask_epi8(exponent) << shift;
+        result.letter |= (uint64_t)(uint32_t)_mm256_movemask_epi8(letter) << shift;
+        result.space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << shift;
+        result.newline |= (uint64_t)(uint32_t)_mm256_movemask_epi8(newline) << shift;
+    }
+    result.other = ~(result.digit | result.sign | result.product | result.open
+        | result.close | result.dot | result.letter | result.space | result.newline);
+    *block = result;
+}
+
+// With AVX-512 each compare gives the 64-bit mask of a class at once.
+__attribute__((target("avx512bw"))) static inline void classifyAvx512(const char *p,
+    Block *block)
+{
+    __m512i x = _mm512_loadu_si512(p);
+    __m512i lower = _mm512_or_si512(x, _mm512_set1_epi8(0x20));
+    Block result;
+    result.digit = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(x, _mm512_set1_epi8('0')),
+        _mm512_set1_epi8(10));
+    result.minus = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('-'));
+    result.sign = result.minus | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('+'));
+    result.product = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('*'))
+        | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('/'));
+    result.open = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('('));
+    result.close = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(')'));
+    result.dot = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('.'));
+    result.exponent = _mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8('e'));
+    result.letter = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(lower, _mm512_set1_epi8('a')),
+                        _mm512_set1_epi8(26))
+        | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('_'));
+    result.space = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(' '))
+        | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\t'))
+        | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\r'));
+    result.newline = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8('\n'));
+    result.other = ~(result.digit | result.sign | result.product | result.open
+        | result.close | result.dot | result.letter | result.space | result.newline);
+    *block = result;
+}
+
+#else /* HAVE_X86_SIMD */
+
+enum CharClass { Digit, Sign, Product, Open, Close, Dot, Exponent, Letter, Space, Newline, Other };
+
+// Character class of each byte, for the scalar fallback.
+struct ClassTable {
+    ClassTable()
+    {
+        memset(table, Other, sizeof(table));
+        for (int c = '0'; c <= '9'; ++c)
+            table[c] = Digit;
+        table['+'] = table['-'] = Sign;
+        table['*'] = table['/'] = Product;
+        table['('] = Open;
+        table[')'] = Close;
+        table['.'] = Dot;
+        for (int c = 'a'; c <= 'z'; ++c)
+            table[c] = table[c - 'a' + 'A'] = Letter;
+        table['_'] = Letter;
+        table['e'] = table['E'] = Exponent;
+        table[' '] = table['\t'] = table['\r'] = Space;
+        table['\n'] = Newline;
+    }
+
+    unsigned char table[256];
+};
+
+static const ClassTable classes;
+
+static inline void classifyScalar(const char *p, Block *block)
+{
+    memset(block, 0, sizeof(*block));
+    for (size_t i = 0; i < StructuralIndexer::BlockSize; ++i) {
+        int c = classes.table[(unsigned char)p[i]];
+        block->digit |= (uint64_t)(c == Digit) << i;
+        block->sign |= (uint64_t)(c == Sign) << i;
+        block->minus |= (uint64_t)(p[i] == '-') << i;
+        block->product |= (uint64_t)(c == Product) << i;
+        block->open |= (uint64_t)(c == Open) << i;
+        block->close |= (uint64_t)(c == Close) << i;
+        block->dot |= (uint64_t)(c == Dot) << i;
+        block->exponent |= (uint64_t)(c == Exponent) << i;
+        block->letter |= (uint64_t)(c == Letter || c == Exponent) << i;
+        block->space |= (uint64_t)(c == Space) << i;
+        block->newline |= (uint64_t)(c == Newline) << i;
+        block->other |= (uint64_t)(c == Other) << i;
+    }
+}
+
+#endif /* HAVE_X86_SIMD */
+
+static inline bool isDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+static inline bool isLetter(char ch)
+{
+    return ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'z') || ch == '_';
+}
+
+// Check the number starting at *pos and move *pos past it:
+// number ::= ( integer ( '.' integer? )? | '.' integer ) ( ( 'e' | 'E' ) ( '+' | '-' )? integer )?
+// On failure *pos is left on the offending character.
+static bool scanNumber(const char *data, size_t length, size_t *pos)
+{
+    size_t p = *pos;
+    size_t digits = p;
+    while (p < length && isDigit(data[p]))
+        ++p;
+    bool integer = p > digits;
+
+    if (p < length && data[p] == '.') {
+        digits = ++p;
+        while (p < length && isDigit(data[p]))
+            ++p;
+        if (!integer && p == digits) {
+            *pos = p;
+            return false;
+        }
+    } else if (!integer) {
+        *pos = p;
+        return false;
+    }
+
+    if (p < length && (data[p] | 0x20) == 'e') {
+        ++p;
+        if (p < length && (data[p] == '+' || data[p] == '-'))
+            ++p;
+        digits = p;
+        while (p < length && isDigit(data[p]))
+            ++p;
+        if (p == digits) {
+            *pos = p;
+            return false;
+        }
+    }
+
+    // the number may not run into another one, or an identifier
+    *pos = p;
+    return p == length || !(isDigit(data[p]) || data[p] == '.' || isLetter(data[p]));
+}
+
+// Move *pos past the identifier starting there.
+static void scanIdentifier(const char *data, size_t length, size_t *pos)
+{
+    size_t p = *pos + 1;
+    while (p < length && (isLetter(data[p]) || isDigit(data[p])))
+        ++p;
+    *pos = p;
+}
+
+// The carries into each bit of generate + (generate | propagate), plus
+// *carry: bit i is set if some bit below i generates and every bit
+// between propagates. *carry becomes the carry out of bit 63.
+static inline uint64_t follows(uint64_t generate, uint64_t propagate, uint64_t *carry)
+{
+    uint64_t x = generate | propagate;
+    unsigned __int128 sum = (unsigned __int128)x + generate + *carry;
+    *carry = (uint64_t)(sum >> 64);
+    return (uint64_t)sum ^ x ^ generate;
+}
+
+// What validate() carries from a block into the next: mostly the bit
+// that went out of the top of a mask. A line starts with all zero but
+// newline.
+struct BlockCarries {
+    uint64_t word = 0; // last byte in an operand
+    uint64_t digit = 0; // ... a digit or a dot
+    uint64_t exponent = 0; // ... an 'e' after a digit or a dot
+    uint64_t number = 0; // ... in a number
+    uint64_t needDigit = 0; // next byte must be a digit
+    uint64_t needExponent = 0; // ... a digit or an exponent sign
+    uint64_t afterE = 0; // in a number, after its exponent
+    uint64_t afterDot = 0; // in a number, after its dot
+    uint64_t operand = 0; // latest token ends an operand
+    uint64_t newline = 1; // no token on the line yet
+    size_t depth = 0; // parentheses open on the line
+};
+
+typedef void (*ClassifyFunction)(const char *, Block *);
+
+// Check the blocks from base on with masks, and return the offset of
+// the first block that fails, or length. The only loop per block is
+// over its parentheses. Each token is a bit at its first byte: an
+// operand (a run of digits, letters and dots, with the sign of an
+// exponent), an operator, a parenthesis or a newline. The state before
+// each token, operand expected or not, comes from the kind of the token
+// before it, found with the carries of an addition, and so do the
+// checks inside numbers. Inlined into a function per instruction set,
+// so that Classify is too.
+template <ClassifyFunction Classify>
+__attribute__((always_inline)) static inline size_t checkBlocks(const char *data,
+    size_t length, size_t base, size_t *lineStart, BlockCarries *carry)
+{
+    const size_t BlockSize = StructuralIndexer::BlockSize;
+
+    for (; base < length; base += BlockSize) {
+        StructuralIndexer::Block block;
+        if (length - base >= BlockSize) {
+            Classify(data + base, &block);
+        } else {
+            char tail[BlockSize];
+            memset(tail, ' ', BlockSize);
+            memcpy(tail, data + base, length - base);
+            Classify(tail, &block);
+        }
+
+        // an exponent sign follows an 'e' after a digit or a dot, and is
+        // part of the operand; in an identifier (a1e+2) it is an error
+        // here, left to the walk
+        uint64_t digit = block.digit | block.dot;
+        uint64_t exponent = block.exponent & (digit << 1 | carry->digit);
+        uint64_t exponentSign = block.sign & (exponent << 1 | carry->exponent);
+        carry->digit = digit >> 63;
+        carry->exponent = exponent >> 63;
+
+        uint64_t word = digit | block.letter | exponentSign;
+        uint64_t start = word & ~(word << 1 | carry->word);
+        carry->word = word >> 63;
+        uint64_t numberStart = start & digit;
+        uint64_t number = follows(numberStart, word & ~start, &carry->number);
+        number = (number | numberStart) & word;
+        exponent = number & block.exponent;
+        uint64_t dot = number & block.dot;
+
+        uint64_t error = block.other;
+
+        // numbers: ( digits ( '.' digits? )? | '.' digits ) ( e sign? digits )?
+        error |= number & block.letter & ~block.exponent;
+        error |= (exponent << 1 | carry->needExponent) & ~(block.digit | exponentSign);
+        uint64_t needDigit = exponentSign | (numberStart & block.dot);
+        error |= (needDigit << 1 | carry->needDigit) & ~block.digit;
+        carry->needExponent = exponent >> 63;
+        carry->needDigit = needDigit >> 63;
+        uint64_t afterE = follows(exponent, number, &carry->afterE);
+        error |= afterE & number & (block.dot | block.exponent);
+        error |= follows(dot, number, &carry->afterDot) & dot;
+        // identifiers: letters and digits
+        error |= word & ~number & (block.dot | exponentSign);
+
+        // operators and operands alternate, with '-' and '(' before an
+        // operand too, and a line with tokens ends after an operand
+        uint64_t sign = block.sign & ~exponentSign;
+        uint64_t operand = start | block.close; // tokens an operand ends with
+        uint64_t tokens = operand | sign | block.product | block.open | block.newline;
+        uint64_t afterOperand = follows(operand, ~tokens, &carry->operand);
+        uint64_t lineEmpty = follows(block.newline, ~tokens, &carry->newline);
+        error |= afterOperand & (start | block.open);
+        error |= ~afterOperand & ((sign & ~block.minus) | block.product | block.close);
+        error |= block.newline & ~afterOperand & ~lineEmpty;
+
+        // parentheses balance on each line
+        uint64_t parentheses = block.open | block.close;
+        if (!parentheses) {
+            error |= carry->depth ? block.newline : 0;
+        } else {
+            for (uint64_t bits = parentheses | block.newline; bits; bits &= bits - 1) {
+                uint64_t bit = bits & -bits;
+                if (block.open & bit) {
+                    ++carry->depth;
+                } else if (block.close & bit) {
+                    error |= carry->depth ? 0 : bit;
+                    carry->depth -= carry->depth != 0;
+                } else {
+                    error |= carry->depth ? bit : 0;
+                    carry->depth = 0;
+                }
+            }
+        }
+
+        if (error)
+            return base;
+        if (block.newline)
+            *lineStart = base + BlockSize - __builtin_clzll(block.newline);
+    }
+    return length;
+}
+
+typedef size_t (*CheckFunction)(const char *, size_t, size_t, size_t *, BlockCarries *);
+
+#ifdef HAVE_X86_SIMD
+
+__attribute__((target("avx512bw"))) static size_t checkBlocksAvx512(const char *data,
+    size_t length, size_t base, size_t *lineStart, BlockCarries *carry)
+{
+    return checkBlocks<classifyAvx512>(data, length, base, lineStart, carry);
+}
+
+__attribute__((target("avx2"))) static size_t checkBlocksAvx2(const char *data,
+    size_t length, size_t base, size_t *lineStart, BlockCarries *carry)
+{
+    return checkBlocks<classifyAvx2>(data, length, base, lineStart, carry);
+}
+
+static size_t checkBlocksSse2(const char *data, size_t length, size_t base,
+    size_t *lineStart, BlockCarries *carry)
+{
+    return checkBlocks<classifySse2>(data, length, base, lineStart, carry);
+}
+
+#else /* HAVE_X86_SIMD */
+
+static size_t checkBlocksScalar(const char *data, size_t length, size_t base,
+    size_t *lineStart, BlockCarries *carry)
+{
+    return checkBlocks<classifyScalar>(data, length, base, lineStart, carry);
+}
+
+#endif /* HAVE_X86_SIMD */
+
+struct Implementation {
+    ClassifyFunction classify;
+    CheckFunction check;
+};
+
+// Pick the widest implementation the running CPU supports.
+static Implementation selectImplementation()
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw"))
+        return Implementation{ classifyAvx512, checkBlocksAvx512 };
+    if (__builtin_cpu_supports("avx2"))
+        return Implementation{ classifyAvx2, checkBlocksAvx2 };
+    return Implementation{ classifySse2, checkBlocksSse2 };
+#else
+    return Implementation{ classifyScalar, checkBlocksScalar };
+#endif
+}
+
+static const Implementation implementation = selectImplementation();
+
+void StructuralIndexer::classify(const char *p, Block *block)
+{
+    implementation.classify(p, block);
+}
+
+// Check blocks with masks. They may reject a valid line, but never
+// accept an invalid one: the lines of a block that fails are walked
+// again token by token, to find the offset of the error if there is
+// one, and the masks take over again at the next line.
+bool Validator::validate(const char *data, size_t length)
+{
+    const size_t BlockSize = StructuralIndexer::BlockSize;
+
+    size_t lineStart = 0; // line holding the first byte of the block
+    BlockCarries carry;
+
+    for (size_t base = 0;;) {
+        base = implementation.check(data, length, base, &lineStart, &carry);
+        if (base == length)
+            break;
+
+        // walk up to the end of the line the block ends in
+        size_t end = base + BlockSize < length ? base + BlockSize : length;
+        const char *newline = (const char *)memchr(data + end, '\n', length - end);
+        end = newline ? newline - data + 1 : length;
+        if (!validateLines(data, end, lineStart))
+            return false;
+        base = lineStart = end;
+        carry = BlockCarries();
+    }
+
+    // a line left open at the end of the buffer
+    if (carry.needDigit || carry.needExponent || carry.depth
+        || (!carry.operand && !carry.newline))
+        return validateLines(data, length, lineStart);
+    return true;
+}
+
+// Walk the token boundaries found by the indexer, from start, the start
+// of a line. Only the first byte of each number, identifier, operator and
+// newline is visited; white space is skipped a whole block at a time.
+bool Validator::validateLines(const char *data, size_t length, size_t start)
+{
+    const size_t BlockSize = StructuralIndexer::BlockSize;
+
+    bool expectNumber = true; // an operand must come next
+    bool lineEmpty = true; // nothing but white space on this line yet
+    size_t depth = 0; // parentheses open on this line
+    size_t numberEnd = 0; // end of the latest number or identifier
+    uint64_t carryNumber = 0; // last byte of the previous block was in a number
+    uint64_t carryLetter = 0; // last byte of the previous block was a letter
+
+    for (size_t base = start; base < length; base += BlockSize) {
+        StructuralIndexer::Block block;
+        if (length - base >= BlockSize) {
+            StructuralIndexer::classify(data + base, &block);
+        } else {
+            char tail[BlockSize];
+            memset(tail, ' ', BlockSize);
+            memcpy(tail, data + base, length - base);
+            StructuralIndexer::classify(tail, &block);
+        }
+
+        // a sign in an exponent starts an event, but one inside the number
+        // just scanned, which is skipped like the rest of it
+        uint64_t number = block.digit | block.dot | block.exponent;
+        uint64_t numberStart = number & ~(number << 1 | carryNumber);
+        uint64_t operators = block.sign;
+        uint64_t letterStart = block.letter & ~(block.letter << 1 | carryLetter);
+        carryNumber = number >> 63;
+        carryLetter = block.letter >> 63;
+
+        // an identifier starts at a letter; one starting with 'e' also
+        // comes up as a numberStart
+        uint64_t events = numberStart | letterStart | operators | block.product
+            | block.open | block.close | block.newline | block.other;
+        while (events) {
+            int i = __builtin_ctzll(events);
+            uint64_t bit = events & -events;
+            events ^= bit;
+
+            size_t pos = base + i;
+            if (pos < numberEnd)
+                continue;
+
+            if (block.other & bit) {
+                error = pos;
+                return false;
+            } else if (block.newline & bit) {
+                if ((expectNumber || depth) && !lineEmpty) {
+                    error = pos;
+                    return false;
+                }
+                expectNumber = true;
+                lineEmpty = true;
+                depth = 0;
+            } else if (operators & bit) {
+                // only '-' may stand before an operand
+                if (expectNumber && data[pos] != '-') {
+                    error = pos;
+                    return false;
+                }
+                expectNumber = true;
+                lineEmpty = false;
+            } else if (block.product & bit) {
+                if (expectNumber) {
+                    error = pos;
+                    return false;
+                }
+                expectNumber = true;
+            } else if (block.open & bit) {
+                if (!expectNumber) {
+                    error = pos;
+                    return false;
+                }
+                ++depth;
+                lineEmpty = false;
+            } else if (block.close & bit) {
+                if (expectNumber || !depth) {
+                    error = pos;
+                    return false;
+                }
+                --depth;
+            } else if (isLetter(data[pos])) {
+                if (!expectNumber) {
+                    error = pos;
+                    return false;
+                }
+                numberEnd = pos;
+                scanIdentifier(data, length, &numberEnd);
+                // nor may an identifier run into a number
+                if (numberEnd < length && data[numberEnd] == '.') {
+                    error = numberEnd;
+                    return false;
+                }
+                expectNumber = false;
+                lineEmpty = false;
+            } else {
+                numberEnd = pos;
+                if (!expectNumber || !scanNumber(data, length, &numberEnd)) {
+                    error = expectNumber ? numberEnd : pos;
+                    return false;
+                }
+                expectNumber = false;
+                lineEmpty = false;
+            }
+        }
+    }
+
+    if ((expectNumber || depth) && !lineEmpty) {
+        error = length;
+        return false;
+    }
+    return true;
+}
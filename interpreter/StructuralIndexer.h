@@ -0,0 +1,76 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STRUCTURAL_INDEXER_H
+#define STRUCTURAL_INDEXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stage 1 of the validate-only path: classify the source 64 bytes at a
+// time into one bit per byte for each character class, using AVX-512,
+// AVX2 or SSE2 when the CPU has them and a table lookup otherwise.
+class StructuralIndexer {
+public:
+    static const size_t BlockSize = 64;
+
+    struct Block {
+        uint64_t digit; // '0'..'9'
+        uint64_t sign; // '+' '-'
+        uint64_t minus; // '-', also a sign
+        uint64_t product; // '*' '/'
+        uint64_t open; // '('
+        uint64_t close; // ')'
+        uint64_t dot; // '.'
+        uint64_t exponent; // 'e' 'E'
+        uint64_t letter; // 'a'..'z' 'A'..'Z' '_', overlapping exponent
+        uint64_t space; // ' ' '\t' '\r'
+        uint64_t newline; // '\n'
+        uint64_t other; // anything else
+    };
+
+    // Classify the BlockSize bytes at p.
+    static void classify(const char *p, Block *block);
+};
+
+// Stage 2: check that every line of a buffer is an expression of the
+// Parser grammar, with operators, unary minus and balanced parentheses,
+// without building tokens. Lines holding only white space are ignored.
+// Whole blocks are checked with bit operations on their masks; only the
+// lines of a block that fails are walked token by token.
+class Validator {
+public:
+    Validator()
+        : error(0)
+    {
+    }
+
+    // Return true if the buffer is valid, otherwise remember where the
+    // first offending character is.
+    bool validate(const char *data, size_t length);
+
+    size_t errorOffset() const
+    {
+        return error;
+    }
+
+private:
+    // Walk the lines from start, the start of a line, token by token.
+    bool validateLines(const char *data, size_t length, size_t start);
+
+    size_t error; // offset of the first error
+};
+
+#endif /* STRUCTURAL_INDEXER_H */
@@ -0,0 +1,73 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SumFlattening.h"
+#include <utility>
+#include <vector>
+
+static bool isSum(AbstractNode *node)
+{
+    return node->kind == NodeKind::BinaryExpression
+        && (node->op == Operator::Add || node->op == Operator::Subtract);
+}
+
+// Rewrite the chain rooted at node into a SumExpression, leaving the
+// operands that are not part of it as they are.
+static SumExpression *flattenChain(AbstractNode *root,
+    std::pmr::memory_resource *resource)
+{
+    SumExpression *sum = newNode<SumExpression>(resource, root->token);
+
+    // walk the chain left to right, carrying the sign of each operand
+    std::vector<std::pair<AbstractNode *, double>> pending;
+    pending.push_back({ root, 1.0 });
+    while (!pending.empty()) {
+        AbstractNode *node = pending.back().first;
+        double sign = pending.back().second;
+        pending.pop_back();
+
+        if (isSum(node)) {
+            double rhsSign = node->op == Operator::Subtract ? -sign : sign;
+            pending.push_back({ node->children[1], rhsSign });
+            pending.push_back({ node->children[0], sign });
+        } else if (node->kind == NodeKind::UnaryExpression && node->op == Operator::Negate) {
+            pending.push_back({ node->children[0], -sign });
+        } else if (node->kind == NodeKind::NumberLiteral) {
+            sum->terms.push_back(sign * node->token.number());
+        } else {
+            sum->addChild(node);
+            sum->signs.push_back(sign);
+        }
+    }
+    return sum;
+}
+
+// Every place holding a node still to be rewritten is kept on a work
+// stack instead of recursing, so any depth of tree can be flattened.
+AbstractNode *flattenSums(AbstractNode *root, std::pmr::memory_resource *resource)
+{
+    std::vector<AbstractNode **> slots;
+    slots.push_back(&root);
+    while (!slots.empty()) {
+        AbstractNode **slot = slots.back();
+        slots.pop_back();
+
+        if (isSum(*slot))
+            *slot = flattenChain(*slot, resource);
+        for (AbstractNode *&child : (*slot)->children)
+            slots.push_back(&child);
+    }
+    return root;
+}
@@ -0,0 +1,28 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SUM_FLATTENING_H
+#define SUM_FLATTENING_H
+
+#include "AbstractSyntaxTree.h"
+#include <memory_resource>
+
+// Rewrite each chain of '+' and '-' (and negations within it) in a tree
+// into one SumExpression, whose terms evaluators add by pairwise SIMD
+// summation instead of one long chain of dependent additions. New nodes
+// come from resource; return the new root.
+AbstractNode *flattenSums(AbstractNode *root, std::pmr::memory_resource *resource);
+
+#endif /* SUM_FLATTENING_H */
@@ -0,0 +1,72 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TableScanner.h"
+#include "NumberParser.h"
+#include "ScannerTable.h"
+#include "Trace.h"
+
+const Token &TableScanner::nextToken()
+{
+    using namespace ScannerTable;
+
+    int type;
+    bool lineStart = charStream->currentOffset() == 0;
+    do {
+        charStream->mark();
+        size_t offset = charStream->currentOffset();
+
+        // Run the automaton until no transition is left. Text matching
+        // the skip rule is not kept for a streamed source: the mark
+        // follows it.
+        int state = Start;
+        char ch = charStream->currentChar();
+        for (;;) {
+            int next = transition[state][charClass[(unsigned char)ch]];
+            if (next == Dead)
+                break;
+            state = next;
+            if (accept[state] == Skip) {
+                lineStart |= ch == '\n';
+                charStream->mark();
+            }
+            ch = charStream->nextChar();
+        }
+
+        if (state == Start) {
+            if (ch != EOF) {
+                type = Token::Invalid;
+                charStream->nextChar();
+            } else {
+                type = EOF;
+            }
+        } else if ((type = accept[state]) == Token::None) {
+            type = Token::Invalid;
+        }
+        token = Token(type, offset, charStream->currentOffset() - offset);
+    } while (type == Skip);
+    token.flags = lineStart ? Token::LineStart : 0;
+
+    if (type == Token::Number) {
+        const char *text = charStream->textAt(token.offset);
+        if (decodeInteger(text, token.length, &token.integer))
+            token.flags |= Token::Integer;
+        else
+            token.value = decodeNumber(text, token.length);
+    }
+
+    TRACE_DEBUG(ScanToken, token.type, token.offset);
+    return token;
+}
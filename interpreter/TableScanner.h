@@ -0,0 +1,56 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TABLE_SCANNER_H
+#define TABLE_SCANNER_H
+
+#include "CharStream.h"
+#include "Token.h"
+
+// Scanner driven by the DFA tables generated from Scanner.spec. It hands
+// out the same tokens as Scanner, so either one can feed the parser; new
+// token kinds only need a new line in the spec.
+//
+// The longest match is taken without backtracking: stopping in a state
+// that accepts nothing (e.g. after "1e+") gives an Invalid token, as does
+// a character no rule starts with.
+class TableScanner {
+public:
+    explicit TableScanner(CharStream *charStream)
+        : charStream(charStream)
+    {
+        nextToken();
+    }
+
+    const Token &currentToken() const
+    {
+        return token;
+    }
+
+    const Token &nextToken();
+
+    // The text of a token, valid while it is the current one (a streamed
+    // source keeps no more than that).
+    const char *textOf(const Token &token) const
+    {
+        return charStream->textAt(token.offset);
+    }
+
+private:
+    CharStream *charStream; // source code
+    Token token; // current token
+};
+
+#endif /* TABLE_SCANNER_H */
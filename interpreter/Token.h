@@ -16,41 +16,68 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <iostream>
-#include <string>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <type_traits>
 
+// A token is a small value: it views its text in the source by offset and
+// length (the name of an Identifier is that text), and a Number carries
+// its value decoded by the scanner, so
+// scanning and parsing never allocate per token. A Number written with
+// neither fraction nor exponent that fits 64 bits is flagged Integer and
+// keeps its exact value in integer instead of value.
 struct Token {
 
     enum TokenType { None = 256,
         Number = 257,
         Plus = 258,
-        Minus = 259 };
+        Minus = 259,
+        Star = 260,
+        Slash = 261,
+        LeftParen = 262,
+        RightParen = 263,
+        Invalid = 264, // text no token rule accepts
+        Identifier = 265 };
+
+    enum TokenFlag { LineStart = 1, // first token on its line
+        Integer = 2 }; // a Number holding integer
 
     Token()
-        : text("")
-        , row(0)
-        , column(0)
-        , type(None)
+        : type(None)
+        , flags(0)
+        , length(0)
+        , offset(0)
+        , value(0)
     {
     }
 
-    Token(const std::string &text, int row, int column, int type)
-        : text(text)
-        , row(row)
-        , column(column)
-        , type(type)
+    Token(int type, size_t offset, size_t length, double value = 0)
+        : type(type)
+        , flags(0)
+        , length(length)
+        , offset(offset)
+        , value(value)
     {
     }
 
-    ~Token()
+    // The value of a Number as a double, whichever way it is held.
+    double number() const
     {
-        std::cout << ".. Deleting token: " << text << std::endl;
+        return flags & Integer ? (double)integer : value;
     }
 
-    int type;
-    std::string text; // token string
-    int row; // line number
-    int column; // column number
+    int16_t type;
+    uint16_t flags; // TokenFlag bits
+    uint32_t length; // number of source characters
+    size_t offset; // source offset of the first character
+    union {
+        double value; // decoded value of a Number
+        int64_t integer; // exact value of an Integer Number
+    };
 };
 
+static_assert(std::is_trivially_copyable<Token>::value,
+    "Token must stay a plain value");
+
 #endif /* TOKEN_H */
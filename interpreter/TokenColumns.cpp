@@ -0,0 +1,60 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TokenColumns.h"
+#include "Scanner.h"
+
+// Resize every column to capacity entries.
+static void resizeColumns(TokenColumns *columns, size_t capacity)
+{
+    columns->type.resize(capacity);
+    columns->offset.resize(capacity);
+    columns->length.resize(capacity);
+    columns->value.resize(capacity);
+}
+
+// Columns are sized ahead and filled through raw pointers, so the loop
+// only checks for room once per token; they are trimmed at the end.
+size_t tokenizeAll(const char *data, size_t length, TokenColumns *columns)
+{
+    if (length > UINT32_MAX)
+        throw "TokenizeError: buffer too large!";
+
+    // one token per four characters is typical for expressions
+    size_t first = columns->size();
+    size_t capacity = first + length / 4 + 16;
+    resizeColumns(columns, capacity);
+
+    SpanSource charStream(data, length);
+    Scanner<SpanSource> scanner(&charStream);
+    size_t n = first;
+    for (const Token *token = &scanner.currentToken(); token->type != EOF;
+         token = &scanner.nextToken(), ++n) {
+        if (n == capacity)
+            resizeColumns(columns, capacity *= 2);
+        if (token->length > UINT16_MAX) {
+            // leave the columns as they were before the call
+            resizeColumns(columns, first);
+            throw "TokenizeError: token too long!";
+        }
+        columns->type.data()[n] = (uint8_t)token->type;
+        columns->offset.data()[n] = (uint32_t)token->offset;
+        columns->length.data()[n] = (uint16_t)token->length;
+        columns->value.data()[n] = token->number();
+    }
+
+    resizeColumns(columns, n);
+    return n - first;
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TOKEN_COLUMNS_H
+#define TOKEN_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// The tokens of a whole buffer, stored column by column so that bulk
+// consumers loop over dense arrays. Token i is (type[i], offset[i],
+// length[i], value[i]); type holds the low byte of the Token type, which
+// makes EOF 0xFF. The terminating EOF token is not stored.
+struct TokenColumns {
+    std::vector<uint8_t> type;
+    std::vector<uint32_t> offset;
+    std::vector<uint16_t> length;
+    std::vector<double> value;
+
+    size_t size() const
+    {
+        return type.size();
+    }
+
+    void clear()
+    {
+        type.clear();
+        offset.clear();
+        length.clear();
+        value.clear();
+    }
+};
+
+// Scan a buffer of at most 4 GB in one pass, appending its tokens to
+// columns. Return the number of tokens appended. On a token too long to
+// store, throw with the columns left as they were.
+size_t tokenizeAll(const char *data, size_t length, TokenColumns *columns);
+
+#endif /* TOKEN_COLUMNS_H */
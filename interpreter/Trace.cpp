@@ -0,0 +1,69 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Trace.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+TraceRecord *Trace::ring = nullptr;
+uint64_t Trace::mask = 0;
+uint64_t Trace::next = 0;
+
+static std::string dumpPath; // where dump() writes the ring
+static std::chrono::steady_clock::time_point epoch;
+
+void Trace::open(const char *path, size_t capacity)
+{
+    if (ring)
+        return;
+
+    size_t size = 1;
+    while (size < capacity)
+        size *= 2;
+    ring = new TraceRecord[size];
+    mask = size - 1;
+    dumpPath = path;
+    epoch = std::chrono::steady_clock::now();
+    atexit(dump);
+}
+
+uint64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch)
+        .count();
+}
+
+void Trace::dump()
+{
+    FILE *fp = fopen(dumpPath.c_str(), "wb");
+    if (!fp)
+        return;
+
+    uint64_t size = mask + 1;
+    uint64_t count = next < size ? next : size;
+    TraceHeader header;
+    memcpy(header.magic, "ITRACE1", 8);
+    header.count = count;
+    header.dropped = next - count;
+    fwrite(&header, sizeof(header), 1, fp);
+
+    for (uint64_t i = next - count; i < next; ++i)
+        fwrite(&ring[i & mask], sizeof(TraceRecord), 1, fp);
+    fclose(fp);
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Trace points compile out completely unless TRACE_LEVEL is raised, e.g.
+//     make CPPFLAGS=-DTRACE_LEVEL=2
+// Level 1 traces whole expressions, level 2 also every token and node.
+// Compiled-in trace points still cost only a flag test until a run
+// enables the sink (see Trace::open), which stores fixed-size binary
+// records in a ring buffer; tools/TraceDecoder prints a dump.
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 0
+#endif
+
+#if TRACE_LEVEL >= 1
+#define TRACE_INFO(event, arg0, arg1) Trace::record(Trace::event, arg0, arg1)
+#else
+#define TRACE_INFO(event, arg0, arg1) ((void)0)
+#endif
+
+#if TRACE_LEVEL >= 2
+#define TRACE_DEBUG(event, arg0, arg1) Trace::record(Trace::event, arg0, arg1)
+#else
+#define TRACE_DEBUG(event, arg0, arg1) ((void)0)
+#endif
+
+// Trace events: name, and printf format of the two arguments
+#define DECL_TRACE_EVENT_SET                                         \
+    DECL_TRACE_EVENT(ScanToken, "type %lld, offset %lld")            \
+    DECL_TRACE_EVENT(CreateNode, "token type %lld, offset %lld")     \
+    DECL_TRACE_EVENT(AcceptExpression, "offset %lld, length %lld")
+
+struct TraceRecord {
+    uint64_t time; // nanoseconds since the sink was opened
+    uint64_t event;
+    uint64_t arg0;
+    uint64_t arg1;
+};
+
+// Header of a trace dump, followed by count records, oldest first.
+struct TraceHeader {
+    char magic[8]; // "ITRACE1"
+    uint64_t count;
+    uint64_t dropped; // records overwritten in the ring
+};
+
+class Trace {
+public:
+#define DECL_TRACE_EVENT(name, format) name,
+    enum Event { DECL_TRACE_EVENT_SET EventCount };
+#undef DECL_TRACE_EVENT
+
+    // Start recording into a ring of capacity records (rounded up to a
+    // power of two), written to path when the program exits.
+    static void open(const char *path, size_t capacity);
+
+    static void record(Event event, uint64_t arg0, uint64_t arg1)
+    {
+        if (!ring)
+            return;
+        TraceRecord &r = ring[next++ & mask];
+        r.time = now();
+        r.event = event;
+        r.arg0 = arg0;
+        r.arg1 = arg1;
+    }
+
+private:
+    static uint64_t now();
+    static void dump();
+
+    static TraceRecord *ring; // null while tracing is off
+    static uint64_t mask; // ring capacity - 1
+    static uint64_t next; // number of records written so far
+};
+
+#endif /* TRACE_H */
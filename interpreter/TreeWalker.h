@@ -0,0 +1,50 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TREE_WALKER_H
+#define TREE_WALKER_H
+
+#include "AbstractSyntaxTree.h"
+#include <vector>
+
+// Depth-first walk of a tree on an explicit stack, so that any depth
+// fits in memory rather than in the C++ call stack. step(node, done) is
+// called each time done of the node's children have been walked: first
+// with 0, last with children.size(), so a leaf is stepped once and the
+// last call of a node comes after all of its children (post-order).
+template <class Step>
+void walkTree(AbstractNode *root, Step &&step)
+{
+    struct Frame {
+        AbstractNode *node;
+        size_t done; // children walked so far
+    };
+
+    std::vector<Frame> stack;
+    stack.push_back(Frame{ root, 0 });
+    while (!stack.empty()) {
+        AbstractNode *node = stack.back().node;
+        size_t done = stack.back().done;
+        step(node, done);
+        if (done == node->children.size()) {
+            stack.pop_back();
+        } else {
+            stack.back().done = done + 1;
+            stack.push_back(Frame{ node->children[done], 0 });
+        }
+    }
+}
+
+#endif /* TREE_WALKER_H */
@@ -0,0 +1,138 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VALUE_H
+#define VALUE_H
+
+#include "Token.h"
+#include <stdint.h>
+#include <iosfwd>
+
+// A number computed by an expression: an exact 64-bit integer as long as
+// integer arithmetic stays in range, otherwise a double. An operation
+// whose integer result would overflow, or is not an integer (7 / 2),
+// gives a Real instead. Integer 0 is +0: a result that is -0 in IEEE
+// arithmetic (-0, 0 * -1, 0 / -3) is a Real, so 1 / (0 * -1) is -inf as
+// in the double evaluators.
+struct Value {
+    enum Kind : uint8_t { Integer,
+        Real };
+
+    Value()
+        : kind(Integer)
+        , integer(0)
+    {
+    }
+
+    static Value ofInteger(int64_t integer)
+    {
+        Value v;
+        v.integer = integer;
+        return v;
+    }
+
+    static Value ofReal(double real)
+    {
+        Value v;
+        v.kind = Real;
+        v.real = real;
+        return v;
+    }
+
+    // The value of a Number token.
+    static Value of(const Token &literal)
+    {
+        return literal.flags & Token::Integer ? ofInteger(literal.integer)
+                                              : ofReal(literal.value);
+    }
+
+    double toDouble() const
+    {
+        return kind == Integer ? (double)integer : real;
+    }
+
+    Kind kind;
+    union {
+        int64_t integer;
+        double real;
+    };
+};
+
+inline bool bothIntegers(Value a, Value b)
+{
+    return a.kind == Value::Integer && b.kind == Value::Integer;
+}
+
+inline bool isRealZero(Value a)
+{
+    return a.kind == Value::Real && a.real == 0;
+}
+
+// -0 has no Integer, so it is a Real as in IEEE arithmetic: 1 / -0 is
+// -inf.
+inline Value negate(Value a)
+{
+    if (a.kind == Value::Integer && a.integer != 0 && a.integer != INT64_MIN)
+        return Value::ofInteger(-a.integer);
+    return Value::ofReal(-a.toDouble());
+}
+
+// A zero Real leaves the Integer operand exact: -0 + n is n.
+inline Value add(Value a, Value b)
+{
+    int64_t r;
+    if (bothIntegers(a, b) && !__builtin_add_overflow(a.integer, b.integer, &r))
+        return Value::ofInteger(r);
+    if (isRealZero(a) && b.kind == Value::Integer)
+        return b;
+    if (isRealZero(b) && a.kind == Value::Integer)
+        return a;
+    return Value::ofReal(a.toDouble() + b.toDouble());
+}
+
+inline Value subtract(Value a, Value b)
+{
+    int64_t r;
+    if (bothIntegers(a, b) && !__builtin_sub_overflow(a.integer, b.integer, &r))
+        return Value::ofInteger(r);
+    if (isRealZero(b) && a.kind == Value::Integer)
+        return a;
+    if (isRealZero(a) && b.kind == Value::Integer && b.integer != 0)
+        return negate(b);
+    return Value::ofReal(a.toDouble() - b.toDouble());
+}
+
+inline Value multiply(Value a, Value b)
+{
+    int64_t r;
+    if (bothIntegers(a, b) && !__builtin_mul_overflow(a.integer, b.integer, &r)
+        && (r != 0 || (a.integer >= 0 && b.integer >= 0)))
+        return Value::ofInteger(r);
+    return Value::ofReal(a.toDouble() * b.toDouble());
+}
+
+// Integer only when the quotient is exact.
+inline Value divide(Value a, Value b)
+{
+    if (bothIntegers(a, b) && b.integer != 0 && !(b.integer == -1 && a.integer == INT64_MIN)
+        && a.integer % b.integer == 0 && (a.integer != 0 || b.integer > 0))
+        return Value::ofInteger(a.integer / b.integer);
+    return Value::ofReal(a.toDouble() / b.toDouble());
+}
+
+// Print an Integer with all its digits, a Real as a double.
+std::ostream &operator<<(std::ostream &out, Value value);
+
+#endif /* VALUE_H */
@@ -34,13 +34,25 @@
         return visitor->visit(this);           \
     }
 
-class BinaryExpression;
-class NumberLiteral;
+// Every concrete AST node class; a new node type is one more line here
+// (and its class). Visitors, node kinds and static dispatch follow.
+#define AST_NODE_LIST(X) \
+    X(BinaryExpression)  \
+    X(UnaryExpression)   \
+    X(NumberLiteral)     \
+    X(SumExpression)     \
+    X(Variable)
+
+#define AST_NODE_DECL(classname) class classname;
+
+class AbstractNode;
+AST_NODE_LIST(AST_NODE_DECL)
+class FlatTree;
 
 class Visitor {
 public:
-    ABSTRACT_VISIT_METHOD_DECL(BinaryExpression)
-    ABSTRACT_VISIT_METHOD_DECL(NumberLiteral)
+    AST_NODE_LIST(ABSTRACT_VISIT_METHOD_DECL)
+    ABSTRACT_VISIT_METHOD_DECL(FlatTree)
 };
 
 #endif /* VISITOR_PATTERN_H */
@@ -6,6 +6,9 @@
 # Specify target name
 TARGET = interpreter
 
+# std::pmr memory resources need C++17; this overrides the Makefile's flag.
+CXXFLAGS += -std=c++17
+
 # Specify the #include directories which should be searched when compiling the project.
 INCLUDEPATH = .
 
@@ -17,3 +20,51 @@ HEADERS = $(wildcard ./*.h)
 
 # Defines the source files for the project.
 SOURCES = $(wildcard ./*.cpp)
+
+# The table-driven scanner is generated from Scanner.spec at build time.
+.DEFAULT_GOAL := $(TARGET)
+
+GENERATOR = tools/ScannerGenerator
+
+$(GENERATOR): tools/ScannerGenerator.cpp
+	$(LINK.cpp) -O2 -o $@ $<
+
+ScannerTable.h: Scanner.spec $(GENERATOR)
+	./$(GENERATOR) $< $@
+
+TableScanner.o: ScannerTable.h
+
+# Offline tools, built with 'make tools'.
+DECODER = tools/TraceDecoder
+
+$(DECODER): tools/TraceDecoder.cpp Trace.h
+	$(LINK.cpp) -O2 -o $@ $<
+
+# Checks and benchmarks link the interpreter's objects but its main().
+LIBRARY = $(filter-out main.o,$(subst .cpp,.o,$(notdir $(SOURCES))))
+CHECKS = tools/StreamCheck tools/EvaluatorCheck tools/ValidatorCheck
+DEEP_CHECK = tools/DeepCheck
+BENCHMARKS = tools/ScannerBench tools/ValidatorBench tools/TokenizeBench \
+    tools/FlatTreeBench tools/CheckBench tools/ResultBench \
+    tools/VmBench tools/JitBench tools/StaticBench tools/SumBench
+
+$(CHECKS) $(DEEP_CHECK) $(BENCHMARKS): tools/%: tools/%.cpp tools/Benchmark.h $(LIBRARY)
+	$(LINK.cpp) $(INCLUDE) -O2 -o $@ $(filter-out %.h,$^)
+
+.PHONY: tools
+tools: $(DECODER) $(CHECKS) $(DEEP_CHECK) $(BENCHMARKS)
+
+# Regression checks, run with 'make check'; the deep check only runs on
+# small input there, 'make check-deep' runs it on 10M terms (a minute and
+# about 4 GB).
+.PHONY: check check-deep
+check: $(CHECKS) $(DEEP_CHECK)
+	@for c in $(CHECKS); do ./$$c || exit 1; done
+	@./$(DEEP_CHECK) 100000
+check-deep: $(DEEP_CHECK)
+	@./$(DEEP_CHECK)
+
+.PHONY: clean-generated
+clean: clean-generated
+clean-generated:
+	rm -f ScannerTable.h $(GENERATOR) $(DECODER) $(CHECKS) $(DEEP_CHECK) $(BENCHMARKS)
@@ -13,36 +13,239 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include "ExpressionCache.h"
 #include "Interpreter.h"
+#include "MappedFile.h"
+#include "Optimizer.h"
 #include "Parser.h"
+#include "StructuralIndexer.h"
+#include "SumFlattening.h"
+#include "Trace.h"
+#include <stdlib.h>
 #include <iostream>
 
+// Print an error with its source position.
+template <class Source>
+static void report(Source &charStream, const char *message, size_t offset)
+{
+    size_t row, column;
+    charStream.locate(offset, &row, &column);
+    std::cout << message << " (line " << row << ", column " << column << ")"
+              << std::endl;
+}
+
+// Evaluate the tree of a whole source, with each '+'/'-' chain in it
+// flattened into one sum. With fastMath, the optimizer also adds up the
+// literal terms of each sum and cancels opposite ones.
+template <class TokenScanner>
+static Result<Value> evaluatePairwise(Parser<TokenScanner> *parser, bool fastMath)
+{
+    Result<AbstractNode *> tree = parser->tryExpression();
+    if (!tree.ok())
+        return Error{ tree.code(), tree.offset() };
+    AbstractNode *root;
+    if (fastMath) {
+        Optimizer optimizer(parser->memoryResource(), true, Arithmetic::Exact);
+        root = optimizer.optimize(tree.value()); // reassociation flattens sums
+    } else {
+        root = flattenSums(tree.value(), parser->memoryResource());
+    }
+    Interpreter interpreter;
+    return interpreter.tryEvaluate(root);
+}
+
+// Parse and evaluate a whole character source as one expression, and
+// print the answer or the error with its source position. The value is
+// folded while parsing, so no tree is built however long the input is.
+// With pairwise, a tree is built instead and each '+'/'-' chain in it is
+// added up as one sum, by pairwise summation: much more accurate on long
+// sums of reals, but integers are then added as doubles too. fastMath
+// implies pairwise.
+template <class Source>
+static void evaluate(Source &charStream, bool pairwise, bool fastMath)
+{
+    Scanner<Source> scanner(&charStream);
+    Parser<Scanner<Source>> parser(&scanner);
+
+    Result<Value> result = pairwise || fastMath ? evaluatePairwise(&parser, fastMath)
+                                                : parser.tryEvaluate();
+    if (result.ok())
+        std::cout << result.value() << std::endl;
+    else
+        report(charStream, result.message(), result.offset());
+}
+
+// Evaluate a line typed in the REPL, looking it up in the cache first
+// and adding its value to the cache on a miss. The answer comes from the
+// Interpreter, as in file mode: integers stay exact unless fastMath lets
+// the optimizer reassociate sums.
+static void evaluateLine(const std::string &input, ExpressionCache *cache, bool fastMath)
+{
+    std::string key;
+    bool cacheable;
+    {
+        SentinelSource charStream(input.c_str(), input.size());
+        Scanner<SentinelSource> scanner(&charStream);
+        cacheable = ExpressionCache::normalize(&scanner, &key);
+        if (cacheable) {
+            if (const ExpressionCache::Entry *entry = cache->find(key)) {
+                std::cout << entry->value << std::endl;
+                return;
+            }
+        }
+    }
+
+    SentinelSource charStream(input.c_str(), input.size());
+    Scanner<SentinelSource> scanner(&charStream);
+    Parser<Scanner<SentinelSource>> parser(&scanner);
+    Result<AbstractNode *> tree = parser.tryExpression();
+    if (!tree.ok())
+        return report(charStream, tree.message(), tree.offset());
+
+    // folding as the Interpreter computes; without fastMath only exact
+    // passes run, and answers stay what the tree gives
+    Optimizer optimizer(parser.memoryResource(), fastMath, Arithmetic::Exact);
+    AbstractNode *root = optimizer.optimize(tree.value());
+
+    Interpreter interpreter;
+    Result<Value> value = interpreter.tryEvaluate(root);
+    if (!value.ok())
+        return report(charStream, value.message(), value.offset());
+    std::cout << value.value() << std::endl;
+    if (cacheable)
+        cache->insert(key, ExpressionCache::Entry{ value.value() });
+}
+
+// Check that every line of a file is a valid expression, without
+// evaluating anything.
+static void validate(const char *path)
+{
+    MappedFile file(path);
+    Validator validator;
+    if (validator.validate(file.data(), file.size())) {
+        std::cout << "Accepted!" << std::endl;
+    } else {
+        LineIndex lines;
+        lines.scan(file.data(), file.size(), 0);
+        size_t row, column;
+        lines.locate(validator.errorOffset(), &row, &column);
+        std::cout << "Rejected (line " << row << ", column " << column << ")"
+                  << std::endl;
+    }
+}
+
+// Check every line of a file as an expression, and print all the errors
+// found rather than only the first.
+static void check(const char *path)
+{
+    MappedFile file(path);
+    SpanSource charStream(file.data(), file.size());
+    Scanner<SpanSource> scanner(&charStream);
+    Parser<Scanner<SpanSource>> parser(&scanner);
+
+    std::vector<Diagnostic> diagnostics;
+    size_t expressions = parser.check(&diagnostics);
+
+    for (const Diagnostic &diagnostic : diagnostics)
+        report(charStream, errorMessage(diagnostic.code), diagnostic.offset);
+    std::cout << diagnostics.size() << " error(s) in " << expressions
+              << " expression(s)" << std::endl;
+}
+
 // Input examples:
 // 135 + 24 - 8     // valid input
 // 135 + 24 - 8 8   // unexpected integer 8
 // 135 + 24 - 8 +   // expecting an integer
+// -(135 + 24) * 8  // valid input
+// (135 + 24 * 8    // expecting ')'
+//
+// Usage:
+//     ./interpreter [--pairwise] [--fast-math] filename1 filename2 ...
+// ('-' reads one expression streamed from stdin; --pairwise adds long
+// sums pairwise, see evaluate(); --fast-math also reassociates sums and
+// cancels opposite terms, as in x + 3 - 1 + y - x => y + 2, which is
+// wrong when x is an infinity or NaN), or run it interactively (Ctrl+D
+// to finish):
+//     ./interpreter [--fast-math]
+// or only check that each line of the files is a valid expression:
+//     ./interpreter --validate filename1 filename2 ...
+// or list every error on any line of the files:
+//     ./interpreter --check filename1 filename2 ...
+//
+// When built with trace points (see Trace.h), setting INTERPRETER_TRACE
+// to a file name records them there; decode it with tools/TraceDecoder.
 int main(int argc, char **argv)
 {
+    if (const char *path = getenv("INTERPRETER_TRACE"))
+        Trace::open(path, 1 << 20);
+
+    if (argc > 1 && std::string(argv[1]) == "--check") {
+        for (int i = 2; i < argc; i++) {
+            std::cout << "Checking file: " << argv[i] << " ..." << std::endl;
+            try {
+                check(argv[i]);
+            } catch (const char *msg) {
+                std::cout << msg << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--validate") {
+        for (int i = 2; i < argc; i++) {
+            std::cout << "Validating file: " << argv[i] << " ..." << std::endl;
+            try {
+                validate(argv[i]);
+            } catch (const char *msg) {
+                std::cout << msg << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    // reading from file list, each file holds one expression
+    bool pairwise = false, fastMath = false;
+    int first = 1;
+    for (; first < argc; first++) {
+        if (std::string(argv[first]) == "--pairwise")
+            pairwise = true;
+        else if (std::string(argv[first]) == "--fast-math")
+            fastMath = true;
+        else
+            break;
+    }
+    for (int i = first; i < argc; i++) {
+        std::cout << "Processing file: " << argv[i] << " ..." << std::endl;
+        try {
+            if (std::string(argv[i]) == "-") {
+                StreamCharStream charStream(0);
+                evaluate<CharStream>(charStream, pairwise, fastMath);
+            } else {
+                MappedFile file(argv[i]);
+                SpanSource charStream(file.data(), file.size());
+                evaluate(charStream, pairwise, fastMath);
+            }
+        } catch (const char *msg) {
+            std::cout << msg << std::endl;
+        }
+    }
+    if (first < argc)
+        return 0;
+
+    // repeated lines are answered from the cache
+    ExpressionCache cache(1 << 20);
     for (;;) {
         try {
             std::cout << "> ";
 
-            std::string input;
-            std::cin >> input;
-
             // On Unix-like OS, when press Ctrl+D
-            if (input.empty())
+            std::string input;
+            if (!std::getline(std::cin, input))
                 break;
+            if (input.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
 
-            CharStream charStream(input);
-            Scanner scanner(&charStream);
-            Parser parser(&scanner);
-
-            auto ast = parser.expression();
-
-            Interpreter interpreter;
-            ast.get()->accept(&interpreter);
-            std::cout << interpreter.answer() << std::endl;
+            evaluateLine(input, &cache, fastMath);
 
         } catch (const char *msg) {
             std::cout << msg << std::endl;
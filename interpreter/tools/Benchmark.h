@@ -0,0 +1,90 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Helpers shared by the benchmarks and checks in tools/.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string>
+
+// Results are stored here so that the work producing them is kept.
+inline volatile double benchmarkSink;
+
+// Return the best wall time in seconds over runs calls of f.
+template <class Function>
+inline double bestOf(int runs, Function f)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        if (time.count() < best)
+            best = time.count();
+    }
+    return best;
+}
+
+// Return a random nonzero number literal: integers, decimals and
+// exponents.
+inline std::string randomNumber(std::mt19937_64 &random)
+{
+    char text[32];
+    switch (random() % 4) {
+    case 0:
+    case 1:
+        snprintf(text, sizeof(text), "%llu", (unsigned long long)(1 + random() % 99999));
+        break;
+    case 2:
+        snprintf(text, sizeof(text), "%llu.%02llu", (unsigned long long)(1 + random() % 999),
+            (unsigned long long)(random() % 100));
+        break;
+    default:
+        snprintf(text, sizeof(text), "%llue%d", (unsigned long long)(1 + random() % 99),
+            (int)(random() % 9) - 4);
+        break;
+    }
+    return text;
+}
+
+// Return an expression of terms random numbers joined by random
+// operators taken from operators. With perLine set, the terms are
+// rather split into lines of perLine terms, one expression each.
+inline std::string randomExpression(size_t terms, const char *operators = "+-",
+    size_t perLine = 0, unsigned seed = 1)
+{
+    std::mt19937_64 random(seed);
+    std::string operatorSet = operators;
+    std::string text = randomNumber(random);
+    for (size_t i = 1; i < terms; i++) {
+        if (perLine && i % perLine == 0) {
+            text += '\n';
+        } else {
+            text += ' ';
+            text += operatorSet[random() % operatorSet.size()];
+            text += ' ';
+        }
+        text += randomNumber(random);
+    }
+    text += '\n';
+    return text;
+}
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,72 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark showing that Parser::check stays linear on error-dense
+// input: every line of the input is checked at several sizes and error
+// rates, and the time per line should not grow with either.
+//
+// Usage:
+//     CheckBench [lines]
+
+#include "../Parser.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+#include <vector>
+
+// Lines of a few terms each; about one in every errorEvery lines gets
+// a mistake at a random place.
+static std::string generate(size_t lines, size_t errorEvery)
+{
+    static const char *const mistakes[] = { " +", " 3", " )", " (", " * *", " $", " 1e" };
+    std::mt19937_64 random(lines + errorEvery);
+    std::string text;
+    for (size_t i = 0; i < lines; i++) {
+        std::string line = randomExpression(4, "+-*/", 0, (unsigned)random());
+        line.pop_back();
+        if (errorEvery && random() % errorEvery == 0)
+            line.insert(random() % (line.size() + 1), mistakes[random() % 7]);
+        text += line;
+        text += '\n';
+    }
+    return text;
+}
+
+int main(int argc, char **argv)
+{
+    size_t lines = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    static const size_t errorRates[] = { 0, 10, 2, 1 }; // 0: none
+
+    for (size_t errorEvery : errorRates) {
+        for (size_t n = lines / 4; n <= lines; n *= 2) {
+            std::string text = generate(n, errorEvery);
+            size_t errors = 0, expressions = 0;
+            double time = bestOf(3, [&] {
+                SpanSource charStream(text.data(), text.size());
+                Scanner<SpanSource> scanner(&charStream);
+                Parser<Scanner<SpanSource>> parser(&scanner);
+                std::vector<Diagnostic> diagnostics;
+                expressions = parser.check(&diagnostics);
+                errors = diagnostics.size();
+            });
+            char rate[24] = "none"; // "1/" and any size_t
+            if (errorEvery)
+                snprintf(rate, sizeof(rate), "1/%zu", errorEvery);
+            printf("%8zu lines, mistakes in %-4s of them: %8zu errors %7.1f ms %6.1f ns/line\n",
+                expressions, rate, errors, time * 1e3, time * 1e9 / expressions);
+        }
+    }
+    return 0;
+}
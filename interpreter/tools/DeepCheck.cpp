@@ -0,0 +1,138 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Regression checks of every evaluator on huge and deeply nested input:
+// each source is parsed once into a pointer tree and once into a
+// FlatTree, and Interpreter (also over flattened sums), StaticInterpreter,
+// the VM and the JIT (or its Interpreter fallback) must all give the
+// expected answer without running out of C++ stack.
+//
+// Usage:
+//     DeepCheck [terms]
+// with 10000000 terms or levels of nesting by default.
+
+#include "../Interpreter.h"
+#include "../Jit.h"
+#include "../Parser.h"
+#include "../StaticVisitor.h"
+#include "../SumFlattening.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef Scanner<SpanSource> TokenScanner;
+
+static int failures = 0;
+
+static void check(bool passed, const std::string &what)
+{
+    printf("%-4s %s\n", passed ? "ok" : "FAIL", what.c_str());
+    failures += !passed;
+}
+
+// Evaluate a source with each evaluator and check each answer.
+static void checkSource(const char *name, const std::string &text, double expected)
+{
+    std::string what = std::string(name) + ": ";
+
+    SpanSource charStream(text.data(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    Result<Value> folded = parser.tryEvaluate();
+    check(folded.ok() && folded.value().toDouble() == expected, what + "parser");
+
+    SpanSource treeStream(text.data(), text.size());
+    TokenScanner treeScanner(&treeStream);
+    Parser<TokenScanner> treeParser(&treeScanner);
+    Result<AbstractNode *> tree = treeParser.tryExpression();
+    if (!tree.ok())
+        return check(false, what + "tree");
+
+    Interpreter interpreter;
+    Result<Value> value = interpreter.tryEvaluate(tree.value());
+    check(value.ok() && value.value().toDouble() == expected, what + "Interpreter");
+
+    StaticInterpreter staticInterpreter;
+    check(staticInterpreter.dispatch(tree.value()) == expected, what + "StaticInterpreter");
+
+    Program program;
+    Compiler compiler(&program);
+    VirtualMachine machine;
+    check(compiler.tryCompile(tree.value()).ok() && machine.run(program) == expected,
+        what + "VM");
+
+    JitExpression jit;
+    Result<bool> compiled = jit.compile(tree.value());
+    check(compiled.ok() && jit.run() == expected,
+        what + (jit.native() ? "JIT" : "JIT fallback"));
+
+    AbstractNode *sums = flattenSums(tree.value(), treeParser.memoryResource());
+    Result<Value> pairwise = interpreter.tryEvaluate(sums);
+    check(pairwise.ok() && pairwise.value().toDouble() == expected,
+        what + "flattened sums");
+    treeParser.release();
+
+    SpanSource flatStream(text.data(), text.size());
+    TokenScanner flatScanner(&flatStream);
+    Parser<TokenScanner> flatParser(&flatScanner);
+    FlatTree flat;
+    if (!flatParser.tryExpression(&flat).ok())
+        return check(false, what + "FlatTree");
+    Result<Value> flatValue = interpreter.tryEvaluate(&flat);
+    check(flatValue.ok() && flatValue.value().toDouble() == expected,
+        what + "FlatTree Interpreter");
+    check(compiler.tryCompile(&flat).ok() && machine.run(program) == expected,
+        what + "FlatTree VM");
+}
+
+// text repeated count times
+static std::string repeat(const char *text, size_t count)
+{
+    std::string s;
+    s.reserve(count * strlen(text));
+    for (size_t i = 0; i < count; ++i)
+        s += text;
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+    if (n < 2) {
+        fprintf(stderr, "terms must be at least 2\n");
+        return 1;
+    }
+
+    // 1 + 1 - 1 + 1 ...: as long as possible, but shallow
+    std::string chain = "1" + repeat("+1-1", n / 2);
+    checkSource("long sum", chain, 1);
+
+    // -(-(...-(1)...)): a chain of unary nodes
+    checkSource("nested negation", repeat("-(", n) + "1" + repeat(")", n), n % 2 ? -1 : 1);
+
+    // 1-(1-(...(1)...)): every subtraction waits for its right operand,
+    // which is more than the JIT registers can hold
+    checkSource("nested subtraction", repeat("1-(", n) + "1" + repeat(")", n), n % 2 ? 0 : 1);
+
+    // 2*(0.5*(2*(...))): deep on the right with products
+    checkSource("nested product", repeat("2*(0.5*(", n / 2) + "1" + repeat("))", n / 2), 1);
+
+    if (failures)
+        printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,491 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Regression checks of the evaluators on small inputs: each check
+// prints a line and the program fails if any of them does.
+//
+// Usage:
+//     EvaluatorCheck
+
+#include "../ExpressionBuilder.h"
+#include "../ExpressionCache.h"
+#include "../FlatTree.h"
+#include "../Interpreter.h"
+#include "../Jit.h"
+#include "../Optimizer.h"
+#include "../Parser.h"
+#include "../StaticVisitor.h"
+#include "../SumFlattening.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+    printf("%-4s %s\n", passed ? "ok" : "FAIL", what);
+    failures += !passed;
+}
+
+// Return true if two evaluators agree: Interpreter computes integers
+// exactly where the others round to double, so finite values may differ
+// a little, but NaN, infinities and their signs must match exactly.
+static bool same(double a, double b)
+{
+    if (isnan(a) || isnan(b))
+        return isnan(a) && isnan(b);
+    if (isinf(a) || isinf(b))
+        return isinf(a) && isinf(b) && signbit(a) == signbit(b);
+    return a == b || fabs(a - b) <= 1e-12 * fmax(fabs(a), fabs(b));
+}
+
+// A random expression of about terms numbers and variables x, y, with
+// every operator, unary minus and parentheses nested up to depth.
+static std::string randomSource(std::mt19937_64 &random, int terms, int depth,
+    bool variables = false)
+{
+    if (terms <= 1 || depth == 0) {
+        switch (random() % 8) {
+        case 0:
+            return "-" + randomNumber(random);
+        case 1:
+            if (variables)
+                return random() % 2 ? "x" : "y";
+            return randomNumber(random);
+        default:
+            return randomNumber(random);
+        }
+    }
+    static const char *const operators[] = { " + ", " - ", " * ", " / " };
+    int left = 1 + random() % (terms - 1);
+    std::string text = randomSource(random, left, depth - 1, variables)
+        + operators[random() % 4] + randomSource(random, terms - left, depth - 1, variables);
+    return random() % 3 ? "(" + text + ")" : "-(" + text + ")";
+}
+
+// Parse a line into a pointer tree that outlives the parser.
+class Tree {
+public:
+    explicit Tree(const std::string &text)
+        : text(text)
+        , charStream(this->text.c_str(), this->text.size())
+        , scanner(&charStream)
+        , parser(&scanner)
+        , root(parser.tryExpression().value())
+    {
+    }
+
+    std::string text;
+    SentinelSource charStream;
+    TokenScanner scanner;
+    Parser<TokenScanner> parser;
+    AbstractNode *root;
+};
+
+static void checkErrors()
+{
+    Interpreter interpreter;
+    Tree unknown("1 + x");
+    Result<Value> failed = interpreter.tryEvaluate(unknown.root);
+    check(failed.code() == UnknownVariable && failed.offset() == 4,
+        "a variable is an unknown variable to Interpreter");
+
+    // an error must not stick to the Interpreter
+    Tree valid("1 + 2");
+    valid.root->accept(&interpreter);
+    bool recovered = false;
+    try {
+        recovered = interpreter.answer().toDouble() == 3;
+    } catch (const char *) {
+    }
+    check(recovered, "Interpreter evaluates again after an error");
+
+    FlatTree empty;
+    Result<Value> nothing = interpreter.tryEvaluate(&empty);
+    check(nothing.code() == NumberExpected, "an empty FlatTree is an error");
+
+    // builders report operators they cannot build instead of throwing
+    ValueBuilder values;
+    Token star(Token::Star, 7, 1);
+    Value value = values.unary(star, Value::ofInteger(1));
+    check(values.error.code == UndefinedOperation && values.error.offset == 7
+            && isnan(value.toDouble()),
+        "ValueBuilder reports an undefined operation");
+    FlatTree tree;
+    FlatTreeBuilder nodes(&tree);
+    nodes.binary(Token(Token::LeftParen, 3, 1), nodes.number(Token(Token::Number, 0, 1)),
+        nodes.number(Token(Token::Number, 2, 1)));
+    check(nodes.error.code == UndefinedOperation && nodes.error.offset == 3,
+        "FlatTreeBuilder reports an undefined operation");
+}
+
+static void checkJit()
+{
+    std::mt19937_64 random(18);
+    Interpreter interpreter;
+    size_t native = 0, differ = 0;
+    for (int i = 0; i < 20000; i++) {
+        Tree tree(randomSource(random, 1 + random() % 12, 1 + random() % 8));
+        JitExpression jit;
+        Result<bool> compiled = jit.compile(tree.root);
+        native += compiled.ok() && compiled.value();
+        differ += !compiled.ok()
+            || !same(jit.run(), interpreter.tryEvaluate(tree.root).value().toDouble());
+    }
+    printf("     %zu of 20000 random expressions compiled to native code\n", native);
+    check(differ == 0, "JIT agrees with Interpreter on random expressions");
+
+    // 17 values are pending before the innermost operator
+    std::string deep = "1";
+    for (int i = 0; i < 20; i++)
+        deep = "2 - (" + deep + ")";
+    Tree nested(deep);
+    JitExpression fallback;
+    Result<bool> compiled = fallback.compile(nested.root);
+    check(compiled.ok() && !compiled.value() && !fallback.native()
+            && fallback.run() == interpreter.tryEvaluate(nested.root).value().toDouble(),
+        "JIT falls back to Interpreter beyond 16 registers");
+
+    Tree variables("2 * x + 1");
+    JitExpression unknown;
+    Result<bool> refused = unknown.compile(variables.root);
+    Result<Value> expected = interpreter.tryEvaluate(variables.root);
+    check(refused.code() == UnknownVariable && refused.offset() == expected.offset()
+            && isnan(unknown.run()),
+        "JIT reports variables as Interpreter does");
+}
+
+static void checkStaticInterpreter()
+{
+    std::mt19937_64 random(20);
+    Interpreter interpreter;
+    StaticInterpreter staticInterpreter;
+    size_t differ = 0;
+    for (int i = 0; i < 20000; i++) {
+        Tree tree(randomSource(random, 1 + random() % 40, 1 + random() % 10));
+        if (i % 2)
+            tree.root = flattenSums(tree.root, tree.parser.memoryResource());
+        differ += !same(staticInterpreter.dispatch(tree.root),
+            interpreter.tryEvaluate(tree.root).value().toDouble());
+    }
+    check(differ == 0, "StaticInterpreter agrees with Interpreter on random expressions");
+
+    Tree variables("1 - x * 2");
+    check(isnan(staticInterpreter.dispatch(variables.root))
+            && interpreter.tryEvaluate(variables.root).code() == UnknownVariable,
+        "StaticInterpreter gives NaN where Interpreter fails");
+}
+
+// Key of a line in the ExpressionCache.
+static std::string cacheKey(const std::string &text)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    std::string key;
+    ExpressionCache::normalize(&scanner, &key);
+    return key;
+}
+
+// Evaluate a line with every evaluator, folded or not, and compare each
+// answer with the expected one.
+static bool allEvaluate(const std::string &text, double expected)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    bool agree = same(parser.tryEvaluate().value().toDouble(), expected);
+
+    Interpreter interpreter;
+    Tree tree(text);
+    agree &= same(interpreter.tryEvaluate(tree.root).value().toDouble(), expected);
+    agree &= same(StaticInterpreter().dispatch(tree.root), expected);
+
+    Program program;
+    VirtualMachine machine;
+    agree &= Compiler(&program).tryCompile(tree.root).ok() && same(machine.run(program), expected);
+    JitExpression jit;
+    agree &= jit.compile(tree.root).ok() && same(jit.run(), expected);
+
+    Tree exact(text);
+    Optimizer forInterpreter(exact.parser.memoryResource(), false, Arithmetic::Exact);
+    AbstractNode *folded = forInterpreter.optimize(exact.root);
+    agree &= same(interpreter.tryEvaluate(folded).value().toDouble(), expected);
+    Tree doubles(text);
+    Optimizer forVm(doubles.parser.memoryResource(), false, Arithmetic::Double);
+    agree &= Compiler(&program).tryCompile(forVm.optimize(doubles.root)).ok()
+        && same(machine.run(program), expected);
+
+    Tree sums(text);
+    AbstractNode *flattened = flattenSums(sums.root, sums.parser.memoryResource());
+    agree &= same(interpreter.tryEvaluate(flattened).value().toDouble(), expected);
+
+    SentinelSource flatStream(text.c_str(), text.size());
+    TokenScanner flatScanner(&flatStream);
+    Parser<TokenScanner> flatParser(&flatScanner);
+    FlatTree flat;
+    if (!flatParser.tryExpression(&flat).ok())
+        return false;
+    agree &= same(interpreter.tryEvaluate(&flat).value().toDouble(), expected);
+    agree &= Compiler(&program).tryCompile(&flat).ok() && same(machine.run(program), expected);
+    return agree;
+}
+
+// The Interpreter's answer to a line, folded first or not.
+static Value exactValue(const std::string &text, bool fold)
+{
+    Interpreter interpreter;
+    Tree tree(text);
+    Optimizer optimizer(tree.parser.memoryResource(), false, Arithmetic::Exact);
+    return interpreter.tryEvaluate(fold ? optimizer.optimize(tree.root) : tree.root).value();
+}
+
+static void checkValues()
+{
+    Value zero = negate(Value::ofInteger(0));
+    check(zero.kind == Value::Real && signbit(zero.real), "-0 is a negative zero Real");
+    Value product = multiply(Value::ofInteger(0), Value::ofInteger(-1));
+    Value quotient = divide(Value::ofInteger(0), Value::ofInteger(-3));
+    check(product.kind == Value::Real && signbit(product.real) && quotient.kind == Value::Real
+            && signbit(quotient.real),
+        "0 * -1 and 0 / -3 are negative zero Reals");
+
+    check(allEvaluate("1 / -0", -INFINITY) && allEvaluate("1 / (0 * -1)", -INFINITY)
+            && allEvaluate("1 / (-5 * 0)", -INFINITY) && allEvaluate("1 / (0 / -3)", -INFINITY)
+            && allEvaluate("1 / (-0 - 0)", -INFINITY) && allEvaluate("1 / (0 * 1)", INFINITY)
+            && allEvaluate("1 / (-0 + 0)", INFINITY) && allEvaluate("1 / (0 - -0)", INFINITY),
+        "every evaluator gives the sign of a zero as IEEE arithmetic");
+
+    size_t exact = 0;
+    for (const char *text : { "-0 + 9007199254740993", "9007199254740993 + -0",
+             "-(5 - 5) + 9007199254740993", "0 * -1 + 9007199254740993",
+             "9007199254740993 - -0", "-0 - 9007199254740993" }) {
+        for (bool fold : { false, true }) {
+            Value value = exactValue(text, fold);
+            exact += value.kind == Value::Integer
+                && (value.integer == 9007199254740993 || value.integer == -9007199254740993);
+        }
+    }
+    check(exact == 12, "-0 next to an integer keeps it exact");
+
+    check(cacheKey("9007199254740993 + 0") != cacheKey("9007199254740992 + 0"),
+        "integers beyond 2^53 have their own cache entries");
+    check(cacheKey("1.0 + 2") != cacheKey("1 + 2") && cacheKey("1+2") == cacheKey(" 1 + 2 "),
+        "integer and real literals have their own cache entries");
+}
+
+static void checkCache()
+{
+    ExpressionCache sizing(SIZE_MAX);
+    sizing.insert("a", ExpressionCache::Entry{ Value::ofInteger(0) });
+    size_t entryBytes = sizing.bytes(); // keys of one byte have the same size
+
+    ExpressionCache cache(3 * entryBytes);
+    for (const char *key : { "a", "b", "c" })
+        cache.insert(key, ExpressionCache::Entry{ Value::ofInteger(*key) });
+    check(cache.bytes() == 3 * entryBytes && cache.evictions() == 0,
+        "cache holds entries up to its byte limit");
+
+    check(cache.find("a") != nullptr, "cache finds an entry");
+    cache.insert("d", ExpressionCache::Entry{ Value::ofInteger('d') });
+    check(cache.find("b") == nullptr && cache.find("c") && cache.find("a") && cache.find("d"),
+        "cache evicts the least recently used entry");
+    check(cache.hits() == 4 && cache.misses() == 1 && cache.evictions() == 1
+            && cache.bytes() == 3 * entryBytes,
+        "cache counts hits, misses and evictions");
+
+    cache.insert("c", ExpressionCache::Entry{ Value::ofInteger(7) });
+    const ExpressionCache::Entry *entry = cache.find("c");
+    check(entry && entry->value.integer == 7 && cache.evictions() == 1
+            && cache.bytes() == 3 * entryBytes,
+        "cache replaces the entry of a known key");
+
+    ExpressionCache small(entryBytes - 1);
+    small.insert("a", ExpressionCache::Entry{ Value::ofInteger(0) });
+    check(!small.find("a") && small.bytes() == 0 && small.evictions() == 1,
+        "cache does not keep an entry larger than its limit");
+}
+
+static void checkBatch()
+{
+    std::mt19937_64 random(24);
+    VirtualMachine machine;
+    size_t differ = 0;
+    for (int i = 0; i < 200; i++) {
+        Tree tree(randomSource(random, 1 + random() % 20, 1 + random() % 8, true));
+        Program program;
+        if (!Compiler(&program).tryCompile(tree.root).ok())
+            return check(false, "random expressions compile");
+
+        // rows on both sides of the block boundaries
+        for (size_t n : { 0, 1, 255, 256, 257, 511, 513, 1000 }) {
+            std::vector<std::vector<double>> columns(program.variables.size(),
+                std::vector<double>(n));
+            std::vector<const double *> pointers;
+            for (std::vector<double> &column : columns) {
+                for (double &value : column)
+                    value = (double)(random() % 2001) / 100 - 10;
+                pointers.push_back(column.data());
+            }
+            std::vector<double> out(n + 1, 42);
+            machine.evaluateBatch(program, pointers.data(), n, out.data());
+
+            std::vector<double> row(columns.size());
+            for (size_t r = 0; r < n; ++r) {
+                for (size_t c = 0; c < columns.size(); ++c)
+                    row[c] = columns[c][r];
+                double expected = machine.run(program, row.data());
+                differ += !(out[r] == expected || (isnan(out[r]) && isnan(expected)));
+            }
+            differ += out[n] != 42; // nothing written past the rows
+        }
+    }
+    check(differ == 0, "evaluateBatch agrees with run() across block boundaries");
+
+    FlatTree tree;
+    tree.addNumber(1);
+    tree.addUnary('+');
+    Program program;
+    Result<Program *> compiled = Compiler(&program).tryCompile(&tree);
+    check(compiled.code() == UndefinedOperation, "Compiler rejects a unary operator other than '-'");
+
+    FlatTree empty;
+    check(Compiler(&program).tryCompile(&empty).code() == NumberExpected,
+        "Compiler rejects an empty FlatTree");
+
+    Tree variables("x * 2");
+    Compiler(&program).tryCompile(variables.root);
+    check(isnan(machine.run(program)), "VM gives NaN without the values of variables");
+}
+
+// Run a tree over rows of x and y, optimized for the VM or not.
+static std::vector<double> runBatch(AbstractNode *root, const double *const *columns,
+    size_t n)
+{
+    Program program;
+    std::vector<double> out(n);
+    if (Compiler(&program).tryCompile(root).ok()) {
+        // slots are numbered as variables appear; columns are x then y
+        std::vector<const double *> slots;
+        for (const Program::Slot &slot : program.variables)
+            slots.push_back(columns[slot.name == "y"]);
+        VirtualMachine().evaluateBatch(program, slots.data(), n, out.data());
+    }
+    return out;
+}
+
+static void checkFolding()
+{
+    // rows of x and y, with zeros and infinities
+    const size_t n = 8;
+    double x[n] = { 1, -1, 0, -0.0, INFINITY, -INFINITY, 2.5, 1e300 };
+    double y[n] = { 3, 0, -0.0, 1, -2, 0.5, -INFINITY, 7 };
+    const double *columns[] = { x, y };
+
+    std::mt19937_64 random(25);
+    Interpreter interpreter;
+    size_t differ = 0, folded = 0;
+    for (int i = 0; i < 5000; i++) {
+        std::string text = randomSource(random, 1 + random() % 12, 1 + random() % 6, true);
+        Tree plain(text);
+        Tree optimized(text);
+        Optimizer optimizer(optimized.parser.memoryResource(), false, Arithmetic::Double);
+        AbstractNode *root = optimizer.optimize(optimized.root);
+        folded += optimizer.reports()[0].removed > 0;
+
+        std::vector<double> expected = runBatch(plain.root, columns, n);
+        std::vector<double> actual = runBatch(root, columns, n);
+        for (size_t r = 0; r < n; ++r)
+            differ += memcmp(&expected[r], &actual[r], sizeof(double)) != 0
+                && !(isnan(expected[r]) && isnan(actual[r]));
+    }
+    printf("     %zu of 5000 random expressions folded\n", folded);
+    check(differ == 0, "folding for the VM keeps evaluateBatch results bit for bit");
+
+    size_t exact = 0;
+    for (int i = 0; i < 5000; i++) {
+        std::string text = randomSource(random, 1 + random() % 12, 1 + random() % 6);
+        Tree plain(text);
+        Tree optimized(text);
+        Optimizer optimizer(optimized.parser.memoryResource());
+        Value a = interpreter.tryEvaluate(plain.root).value();
+        Value b = interpreter.tryEvaluate(optimizer.optimize(optimized.root)).value();
+        exact += a.kind == b.kind
+            && (a.kind == Value::Integer ? a.integer == b.integer
+                                         : memcmp(&a.real, &b.real, sizeof(double)) == 0
+                        || (isnan(a.real) && isnan(b.real)));
+    }
+    check(exact == 5000, "folding for the Interpreter keeps its Values");
+
+    Tree divide("x / -0");
+    Tree divideFolded("x / -0");
+    Optimizer forVm(divideFolded.parser.memoryResource(), false, Arithmetic::Double);
+    check(runBatch(divide.root, columns, n)[0] == -INFINITY
+            && runBatch(forVm.optimize(divideFolded.root), columns, n)[0] == -INFINITY,
+        "x / -0 is -inf folded or not");
+
+    Tree large("(9007199254740992 + 1 + 1) * x");
+    Tree largeFolded("(9007199254740992 + 1 + 1) * x");
+    Optimizer forDoubles(largeFolded.parser.memoryResource(), false, Arithmetic::Double);
+    check(runBatch(large.root, columns, n)[0]
+            == runBatch(forDoubles.optimize(largeFolded.root), columns, n)[0],
+        "integers beyond 2^53 fold as the VM adds them");
+
+    const char *cancelled = "x + 3 - 1 + y - x";
+    Tree fast(cancelled);
+    Optimizer fastMath(fast.parser.memoryResource(), true);
+    AbstractNode *root = fastMath.optimize(fast.root);
+    SumExpression *sum = root->kind == NodeKind::SumExpression
+        ? static_cast<SumExpression *>(root)
+        : nullptr;
+    check(sum && sum->terms.size() == 1 && sum->terms[0] == 2 && sum->children.size() == 1
+            && sum->signs[0] == 1 && sum->children[0]->kind == NodeKind::Variable
+            && static_cast<Variable *>(sum->children[0])->name == "y",
+        "fast math makes x + 3 - 1 + y - x into y + 2");
+
+    // nothing to fold: 3 - 1 is not a node of the left-leaning chain
+    const std::vector<Optimizer::Report> &reports = fastMath.reports();
+    check(reports.size() == 3 && reports[0].removed == 0 && !reports[1].skipped
+            && reports[1].removed > 0 && !reports[2].skipped && reports[2].removed > 0,
+        "fast math reports the nodes reassociation and cancellation remove");
+
+    Tree strict(cancelled);
+    Optimizer exactOnly(strict.parser.memoryResource());
+    exactOnly.optimize(strict.root);
+    check(exactOnly.reports().size() == 3 && !exactOnly.reports()[0].skipped
+            && exactOnly.reports()[1].skipped && exactOnly.reports()[2].skipped,
+        "passes that are not exact are skipped without fast math");
+}
+
+int main()
+{
+    checkErrors();
+    checkJit();
+    checkStaticInterpreter();
+    checkValues();
+    checkCache();
+    checkBatch();
+    checkFolding();
+    if (failures)
+        printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the flat post-order tree against the pointer tree: bytes
+// per node, parse time and evaluation time per node with Interpreter.
+// Both trees must evaluate to the same value.
+//
+// Usage:
+//     FlatTreeBench [terms]
+
+#include "../Interpreter.h"
+#include "../Parser.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+// Count the bytes a pointer tree takes from its memory resource.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t bytes = 0;
+
+private:
+    void *do_allocate(size_t size, size_t alignment) override
+    {
+        bytes += size;
+        return std::pmr::new_delete_resource()->allocate(size, alignment);
+    }
+
+    void do_deallocate(void *p, size_t size, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+static void measure(const char *input, const std::string &text)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    CountingResource counting;
+    Parser<TokenScanner> parser(&scanner, &counting);
+    AbstractNode *root = parser.expression();
+
+    FlatTree tree;
+    double flatParse = bestOf(3, [&] {
+        SentinelSource charStream(text.c_str(), text.size());
+        TokenScanner scanner(&charStream);
+        Parser<TokenScanner> parser(&scanner);
+        tree.clear();
+        parser.expression(&tree);
+    });
+    double pointerParse = bestOf(3, [&] {
+        SentinelSource charStream(text.c_str(), text.size());
+        TokenScanner scanner(&charStream);
+        Parser<TokenScanner> parser(&scanner);
+        parser.expression();
+    });
+
+    Interpreter interpreter;
+    double pointerValue = 0, flatValue = 0;
+    double pointerTime = bestOf(5, [&] {
+        pointerValue = interpreter.tryEvaluate(root).value().toDouble();
+    });
+    double flatTime = bestOf(5, [&] {
+        flatValue = interpreter.tryEvaluate(&tree).value().toDouble();
+    });
+
+    double nodes = tree.nodes.size();
+    printf("%s: %zu nodes%s\n", input, tree.nodes.size(),
+        pointerValue == flatValue ? "" : ", VALUES DIFFER!");
+    printf("  pointer tree %6.1f bytes/node  parse %6.2f ns/node  evaluate %6.2f ns/node\n",
+        counting.bytes / nodes, pointerParse * 1e9 / nodes, pointerTime * 1e9 / nodes);
+    printf("  flat tree    %6.1f bytes/node  parse %6.2f ns/node  evaluate %6.2f ns/node\n",
+        (double)sizeof(FlatNode), flatParse * 1e9 / nodes, flatTime * 1e9 / nodes);
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    measure("sum", randomExpression(terms, "+-"));
+    measure("mixed", randomExpression(terms, "+-+-*/"));
+    return 0;
+}
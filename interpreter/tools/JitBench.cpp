@@ -0,0 +1,82 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the JIT against the tree-walking Interpreter and the VM:
+// time per evaluation of expressions compiled once and evaluated many
+// times.
+//
+// Usage:
+//     JitBench [evaluations]
+
+#include "../Bytecode.h"
+#include "../Interpreter.h"
+#include "../Jit.h"
+#include "../Parser.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+static void measure(size_t terms, size_t evaluations)
+{
+    std::string text = randomExpression(terms, "+-+-*/");
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    AbstractNode *root = parser.expression();
+
+    Program program;
+    Compiler compiler(&program);
+    compiler.tryCompile(root);
+    JitExpression jit;
+    bool native = jit.compile(root).value();
+
+    // as many nodes evaluated in every case
+    size_t runs = evaluations / terms;
+    Interpreter interpreter;
+    VirtualMachine machine;
+    double treeTime = bestOf(3, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < runs; i++)
+            sum += interpreter.tryEvaluate(root).value().toDouble();
+        benchmarkSink = sum;
+    });
+    double vmTime = bestOf(3, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < runs; i++)
+            sum += machine.run(program);
+        benchmarkSink = sum;
+    });
+    double jitTime = bestOf(3, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < runs; i++)
+            sum += jit.run();
+        benchmarkSink = sum;
+    });
+
+    printf("%6zu terms%s: Interpreter %9.1f  VM %8.1f  JIT %8.1f ns/evaluation\n", terms,
+        native ? "" : " (no native code)", treeTime * 1e9 / runs, vmTime * 1e9 / runs,
+        jitTime * 1e9 / runs);
+}
+
+int main(int argc, char **argv)
+{
+    size_t evaluations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    static const size_t sizes[] = { 2, 8, 64, 1000 };
+    for (size_t terms : sizes)
+        measure(terms, evaluations);
+    return 0;
+}
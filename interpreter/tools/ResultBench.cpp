@@ -0,0 +1,71 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the throwing API against the Result API, on a valid and
+// an invalid line: time per parse and evaluation, parser included.
+//
+// Usage:
+//     ResultBench [parses]
+
+#include "../Parser.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+static double throwing(Parser<TokenScanner> *parser)
+{
+    try {
+        return parser->evaluate().toDouble();
+    } catch (const char *) {
+        return -1;
+    }
+}
+
+static double returning(Parser<TokenScanner> *parser)
+{
+    Result<Value> result = parser->tryEvaluate();
+    return result.ok() ? result.value().toDouble() : -1;
+}
+
+// Return the time per parse of line in nanoseconds.
+static double measure(const std::string &line, size_t parses,
+    double (*evaluate)(Parser<TokenScanner> *))
+{
+    double time = bestOf(3, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < parses; i++) {
+            SentinelSource charStream(line.c_str(), line.size());
+            TokenScanner scanner(&charStream);
+            Parser<TokenScanner> parser(&scanner);
+            sum += evaluate(&parser);
+        }
+        benchmarkSink = sum;
+    });
+    return time * 1e9 / parses;
+}
+
+int main(int argc, char **argv)
+{
+    size_t parses = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    static const char *const lines[] = { "1 + 2 * (3 - 4)", "1 + 2 * (3 - )" };
+
+    for (const char *line : lines) {
+        printf("%-18s throwing %7.1f ns  Result %7.1f ns\n", line,
+            measure(line, parses, throwing), measure(line, parses, returning));
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the hand-written scanner over each character source
+// against the table-driven scanner generated from Scanner.spec, in
+// tokens per second. The token streams are compared as well.
+//
+// Usage:
+//     ScannerBench [terms]
+
+#include "../Scanner.h"
+#include "../TableScanner.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+#include <vector>
+
+// Scan the whole text and return the number of tokens.
+template <class TokenScanner, class Source>
+static size_t scan(const std::string &text, std::vector<Token> *tokens = nullptr)
+{
+    Source charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    size_t count = 0;
+    double sum = 0;
+    for (const Token *token = &scanner.currentToken(); token->type != EOF;
+         token = &scanner.nextToken()) {
+        sum += token->number();
+        ++count;
+        if (tokens)
+            tokens->push_back(*token);
+    }
+    benchmarkSink = sum;
+    return count;
+}
+
+template <class TokenScanner, class Source>
+static void measure(const char *name, const std::string &text)
+{
+    size_t count = 0;
+    double time = bestOf(5, [&] { count = scan<TokenScanner, Source>(text); });
+    printf("%-28s %8.1f Mtok/s %8.1f MB/s\n", name, count / time / 1e6, text.size() / time / 1e6);
+}
+
+static bool sameTokens(const Token &a, const Token &b)
+{
+    return a.type == b.type && a.offset == b.offset && a.length == b.length
+        && (a.flags & Token::Integer) == (b.flags & Token::Integer)
+        && (a.type != Token::Number || a.number() == b.number());
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    std::string text = randomExpression(terms, "+-*/", 16);
+
+    std::vector<Token> hand, table;
+    scan<Scanner<SpanSource>, SpanSource>(text, &hand);
+    scan<TableScanner, CharStream>(text, &table);
+    size_t mismatches = hand.size() == table.size() ? 0 : 1;
+    for (size_t i = 0; i < hand.size() && i < table.size(); i++)
+        mismatches += !sameTokens(hand[i], table[i]);
+    printf("%zu tokens, %zu bytes, %zu mismatching\n", hand.size(), text.size(), mismatches);
+
+    measure<Scanner<CharStream>, CharStream>("Scanner<CharStream>", text);
+    measure<Scanner<SpanSource>, SpanSource>("Scanner<SpanSource>", text);
+    measure<Scanner<SentinelSource>, SentinelSource>("Scanner<SentinelSource>", text);
+    measure<TableScanner, CharStream>("TableScanner", text);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,335 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Build-time generator of the table-driven scanner.
+//
+// Reads the rules of Scanner.spec, builds a Thompson NFA for each one,
+// turns their union into a DFA by subset construction, merges the bytes
+// that behave alike into character classes, and writes the resulting
+// dense tables as a C++ header.
+//
+// Usage:
+//     ScannerGenerator Scanner.spec ScannerTable.h
+
+#include <bitset>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct NfaState {
+    std::bitset<256> chars; // bytes leading to target
+    int target = -1;
+    std::vector<int> epsilon; // targets reached without input
+    int rule = -1; // index of the rule accepted here
+};
+
+struct Fragment {
+    int start;
+    int end;
+};
+
+static std::vector<NfaState> nfa;
+
+static int newState()
+{
+    nfa.push_back(NfaState());
+    return nfa.size() - 1;
+}
+
+static void fail(const std::string &msg, const std::string &pattern)
+{
+    std::cerr << "ScannerGenerator: " << msg << " in: " << pattern << std::endl;
+    exit(1);
+}
+
+// Recursive descent parser of the rule expressions.
+//     alternation ::= concatenation ( '|' concatenation )*
+//     concatenation ::= repetition*
+//     repetition ::= atom ( '*' | '+' | '?' )*
+//     atom ::= '(' alternation ')' | literal | class
+class RegexParser {
+public:
+    explicit RegexParser(const std::string &pattern)
+        : pattern(pattern)
+        , pos(0)
+    {
+    }
+
+    Fragment parse()
+    {
+        Fragment f = alternation();
+        skipSpace();
+        if (pos != pattern.size())
+            fail("unexpected character", pattern);
+        return f;
+    }
+
+private:
+    void skipSpace()
+    {
+        while (pos < pattern.size() && isspace((unsigned char)pattern[pos]))
+            ++pos;
+    }
+
+    int peek()
+    {
+        skipSpace();
+        return pos < pattern.size() ? (unsigned char)pattern[pos] : -1;
+    }
+
+    // Read one possibly escaped byte of a literal or class.
+    unsigned char escaped()
+    {
+        if (pos >= pattern.size())
+            fail("unterminated literal", pattern);
+        char ch = pattern[pos++];
+        if (ch != '\\')
+            return ch;
+        if (pos >= pattern.size())
+            fail("dangling escape", pattern);
+        switch (ch = pattern[pos++]) {
+        case 't':
+            return '\t';
+        case 'r':
+            return '\r';
+        case 'n':
+            return '\n';
+        default:
+            return ch;
+        }
+    }
+
+    Fragment alternation()
+    {
+        Fragment f = concatenation();
+        while (peek() == '|') {
+            ++pos;
+            Fragment g = concatenation();
+            int s = newState(), e = newState();
+            nfa[s].epsilon = { f.start, g.start };
+            nfa[f.end].epsilon.push_back(e);
+            nfa[g.end].epsilon.push_back(e);
+            f = { s, e };
+        }
+        return f;
+    }
+
+    Fragment concatenation()
+    {
+        int s = newState();
+        Fragment f = { s, s };
+        for (int ch = peek(); ch != -1 && ch != '|' && ch != ')'; ch = peek()) {
+            Fragment g = repetition();
+            nfa[f.end].epsilon.push_back(g.start);
+            f.end = g.end;
+        }
+        return f;
+    }
+
+    Fragment repetition()
+    {
+        Fragment f = atom();
+        for (int ch = peek(); ch == '*' || ch == '+' || ch == '?'; ch = peek()) {
+            ++pos;
+            int s = newState(), e = newState();
+            nfa[s].epsilon.push_back(f.start);
+            nfa[f.end].epsilon.push_back(e);
+            if (ch != '+')
+                nfa[s].epsilon.push_back(e); // may be skipped
+            if (ch != '?')
+                nfa[f.end].epsilon.push_back(f.start); // may repeat
+            f = { s, e };
+        }
+        return f;
+    }
+
+    Fragment atom()
+    {
+        int ch = peek();
+        if (ch == '(') {
+            ++pos;
+            Fragment f = alternation();
+            if (peek() != ')')
+                fail("missing ')'", pattern);
+            ++pos;
+            return f;
+        } else if (ch == '\'') {
+            ++pos;
+            int s = newState();
+            Fragment f = { s, s };
+            while (pos < pattern.size() && pattern[pos] != '\'') {
+                int e = newState();
+                nfa[f.end].chars.set(escaped());
+                nfa[f.end].target = e;
+                f.end = e;
+            }
+            if (pos++ >= pattern.size())
+                fail("unterminated literal", pattern);
+            return f;
+        } else if (ch == '[') {
+            ++pos;
+            int s = newState(), e = newState();
+            while (pos < pattern.size() && pattern[pos] != ']') {
+                unsigned char lo = escaped(), hi = lo;
+                if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']') {
+                    ++pos;
+                    hi = escaped();
+                }
+                for (int c = lo; c <= hi; ++c)
+                    nfa[s].chars.set(c);
+            }
+            if (pos++ >= pattern.size())
+                fail("unterminated class", pattern);
+            nfa[s].target = e;
+            return { s, e };
+        }
+        fail("unexpected character", pattern);
+        return { -1, -1 };
+    }
+
+    std::string pattern;
+    size_t pos;
+};
+
+// Add every state reachable through epsilon moves.
+static std::vector<int> closure(std::set<int> states)
+{
+    std::vector<int> work(states.begin(), states.end());
+    while (!work.empty()) {
+        int s = work.back();
+        work.pop_back();
+        for (int t : nfa[s].epsilon)
+            if (states.insert(t).second)
+                work.push_back(t);
+    }
+    return std::vector<int>(states.begin(), states.end());
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: ScannerGenerator spec header" << std::endl;
+        return 1;
+    }
+
+    std::ifstream spec(argv[1]);
+    if (!spec) {
+        std::cerr << "ScannerGenerator: cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // Read the rules, joining them under one start state.
+    std::vector<std::string> names;
+    int start = newState();
+    std::string line;
+    while (std::getline(spec, line)) {
+        std::istringstream in(line);
+        std::string name, pattern;
+        if (!(in >> name) || name[0] == '#')
+            continue;
+        std::getline(in, pattern);
+        Fragment f = RegexParser(pattern).parse();
+        nfa[start].epsilon.push_back(f.start);
+        nfa[f.end].rule = names.size();
+        names.push_back(name);
+    }
+
+    // Subset construction, state 0 is the dead state.
+    std::vector<std::vector<int>> sets = { {}, closure({ start }) };
+    std::map<std::vector<int>, int> ids = { { sets[0], 0 }, { sets[1], 1 } };
+    std::vector<std::vector<int>> moves;
+    for (size_t d = 0; d < sets.size(); ++d) {
+        std::vector<int> row(256);
+        for (int c = 0; c < 256; ++c) {
+            std::set<int> next;
+            for (int s : sets[d])
+                if (nfa[s].chars.test(c))
+                    next.insert(nfa[s].target);
+            std::vector<int> target = closure(next);
+            auto it = ids.find(target);
+            if (it == ids.end()) {
+                it = ids.insert({ target, (int)sets.size() }).first;
+                sets.push_back(target);
+            }
+            row[c] = it->second;
+        }
+        moves.push_back(row);
+    }
+    if (sets.size() > 256) {
+        std::cerr << "ScannerGenerator: too many states" << std::endl;
+        return 1;
+    }
+
+    // Bytes with identical columns share one character class.
+    std::map<std::vector<int>, int> columns;
+    std::vector<int> charClass(256);
+    for (int c = 0; c < 256; ++c) {
+        std::vector<int> column;
+        for (auto &row : moves)
+            column.push_back(row[c]);
+        auto it = columns.insert({ column, (int)columns.size() }).first;
+        charClass[c] = it->second;
+    }
+    std::vector<int> representative(columns.size());
+    for (int c = 255; c >= 0; --c)
+        representative[charClass[c]] = c;
+
+    std::ofstream out(argv[2]);
+    out << "// Generated by tools/ScannerGenerator from " << argv[1] << " - do not edit!\n\n"
+        << "#ifndef SCANNER_TABLE_H\n"
+        << "#define SCANNER_TABLE_H\n\n"
+        << "#include \"Token.h\"\n\n"
+        << "namespace ScannerTable {\n\n"
+        << "enum { Dead = 0, Start = 1, Skip = -2 };\n\n"
+        << "const int classCount = " << columns.size() << ";\n"
+        << "const int stateCount = " << sets.size() << ";\n\n"
+        << "// Character class of each byte\n"
+        << "const unsigned char charClass[256] = {";
+    for (int c = 0; c < 256; ++c)
+        out << (c % 16 ? " " : "\n    ") << charClass[c] << ",";
+    out << "\n};\n\n"
+        << "// Next state by state and character class\n"
+        << "const unsigned char transition[stateCount][classCount] = {\n";
+    for (auto &row : moves) {
+        out << "    {";
+        for (size_t k = 0; k < columns.size(); ++k)
+            out << (k ? ", " : " ") << row[representative[k]];
+        out << " },\n";
+    }
+    out << "};\n\n"
+        << "// Token type accepted by each state\n"
+        << "const int accept[stateCount] = {\n";
+    for (auto &set : sets) {
+        int rule = -1;
+        for (int s : set)
+            if (nfa[s].rule != -1 && (rule == -1 || nfa[s].rule < rule))
+                rule = nfa[s].rule;
+        if (rule == -1)
+            out << "    Token::None,\n";
+        else if (names[rule] == "skip")
+            out << "    Skip,\n";
+        else
+            out << "    Token::" << names[rule] << ",\n";
+    }
+    out << "};\n\n"
+        << "} // namespace ScannerTable\n\n"
+        << "#endif /* SCANNER_TABLE_H */\n";
+
+    return out ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the statically dispatched StaticInterpreter against a
+// visitor dispatched virtually, accept() then visit(), at every node,
+// per node of long chains. Both walk the tree the same way and compute
+// in double, so only the dispatch differs. Interpreter, which switches
+// on node kinds and computes with Value, is listed too.
+//
+// Usage:
+//     StaticBench [terms]
+
+#include "../AbstractSyntaxTree.h"
+#include "../Interpreter.h"
+#include "../Parser.h"
+#include "../StaticVisitor.h"
+#include "../TreeWalker.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+// StaticInterpreter with a virtual call per node: each node is stepped
+// after its children and dispatched through accept().
+class VirtualInterpreter : public Visitor {
+public:
+    double evaluate(AbstractNode *root)
+    {
+        walkTree(root, [this](AbstractNode *node, size_t done) {
+            if (done == node->children.size())
+                node->accept(this);
+        });
+        double result = values.back();
+        values.clear();
+        return result;
+    }
+
+    void visit(BinaryExpression *binexp)
+    {
+        double b = values.back();
+        values.pop_back();
+        double &a = values.back();
+        switch (binexp->op) {
+        case Operator::Add:
+            a += b;
+            break;
+        case Operator::Subtract:
+            a -= b;
+            break;
+        case Operator::Multiply:
+            a *= b;
+            break;
+        case Operator::Divide:
+            a /= b;
+            break;
+        default:
+            a = NAN;
+        }
+    }
+
+    void visit(UnaryExpression *unexp)
+    {
+        values.back() = unexp->op == Operator::Negate ? -values.back() : NAN;
+    }
+
+    void visit(NumberLiteral *number)
+    {
+        values.push_back(number->token.number());
+    }
+
+    void visit(SumExpression *)
+    {
+        values.push_back(NAN); // not in these chains
+    }
+
+    void visit(Variable *)
+    {
+        values.push_back(NAN);
+    }
+
+    void visit(FlatTree *)
+    {
+    }
+
+private:
+    std::vector<double> values; // results of the nodes walked
+};
+
+// A chain of terms numbers has 2 * terms - 1 nodes.
+static void measure(const char *input, size_t terms, const std::string &text)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    AbstractNode *root = parser.expression();
+
+    Interpreter interpreter;
+    VirtualInterpreter virtualInterpreter;
+    StaticInterpreter staticInterpreter;
+    double value = 0, virtualValue = 0, staticValue = 0;
+    int runs = text.size() < 100000 ? 1000 : 10;
+    double time = bestOf(runs, [&] {
+        value = interpreter.tryEvaluate(root).value().toDouble();
+    });
+    double virtualTime = bestOf(runs, [&] { virtualValue = virtualInterpreter.evaluate(root); });
+    double staticTime = bestOf(runs, [&] { staticValue = staticInterpreter.dispatch(root); });
+
+    double nodes = 2 * terms - 1;
+    printf("%-14s virtual %6.2f  static %6.2f  Interpreter %6.2f ns/node%s\n", input,
+        virtualTime * 1e9 / nodes, staticTime * 1e9 / nodes, time * 1e9 / nodes,
+        virtualValue != staticValue    ? "  (visitors differ!)"
+            : value != staticValue ? "  (Interpreter differs in rounding)"
+                                   : "");
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    for (size_t n = 1000; n <= terms; n *= 10) {
+        char name[32];
+        snprintf(name, sizeof(name), "sum %zu", n);
+        measure(name, n, randomExpression(n, "+-"));
+        snprintf(name, sizeof(name), "mixed %zu", n);
+        measure(name, n, randomExpression(n, "+-+-*/"));
+    }
+    return 0;
+}
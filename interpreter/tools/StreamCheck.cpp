@@ -0,0 +1,147 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Regression checks that streamed input is scanned in bounded memory.
+// Each case pipes a long generated source through StreamCharStream into
+// both scanners and fails if the answer, the error position or the peak
+// resident memory is not as expected.
+//
+// Usage:
+//     StreamCheck
+
+#include "../Parser.h"
+#include <signal.h>
+#include <stdio.h>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const long memoryLimit = 48 * 1024; // peak resident KB allowed
+
+struct Case {
+    const char *name;
+    const char *head; // written once first
+    const char *body; // then repeated count times
+    size_t count;
+    const char *tail; // and written once last
+    const char *expected; // answer or error with its position
+};
+
+static const Case cases[] = {
+    { "many lines", "1\n", "+1\n", 20000000, "+\n",
+        "SyntaxError: number is expected! (line 20000003, column 1)" },
+    { "long blanks", "", "          ", 20000000, "1 + x", "Unknown variable! (line 1, column 200000005)" },
+    { "blank lines", "", "\n  \n", 10000000, "2 * 21", "42" },
+};
+
+static void writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n <= 0)
+            _exit(1);
+        data += n;
+        size -= n;
+    }
+}
+
+// Write the source of a case into fd, in a child process.
+static pid_t produce(const Case &c, int fd)
+{
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    std::string chunk;
+    while (chunk.size() < 64 * 1024)
+        chunk += c.body;
+    size_t perChunk = chunk.size() / strlen(c.body);
+
+    writeAll(fd, c.head, strlen(c.head));
+    for (size_t left = c.count; left > 0;) {
+        size_t n = left < perChunk ? left : perChunk;
+        writeAll(fd, chunk.data(), n * strlen(c.body));
+        left -= n;
+    }
+    writeAll(fd, c.tail, strlen(c.tail));
+    _exit(0);
+}
+
+// Evaluate the stream and print the outcome as main.cpp would.
+template <class TokenScanner>
+static std::string evaluate(int fd)
+{
+    StreamCharStream charStream(fd);
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+
+    std::ostringstream out;
+    Result<Value> result = parser.tryEvaluate();
+    if (result.ok()) {
+        out << result.value();
+    } else {
+        size_t row, column;
+        charStream.locate(result.offset(), &row, &column);
+        out << result.message() << " (line " << row << ", column " << column << ")";
+    }
+    return out.str();
+}
+
+// Run a case in a child process of its own, so that its peak memory
+// is measured alone.
+template <class TokenScanner>
+static bool run(const Case &c, const char *scannerName)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            _exit(2);
+        pid_t writer = produce(c, fds[1]);
+        close(fds[1]);
+        std::string outcome = evaluate<TokenScanner>(fds[0]);
+        close(fds[0]);
+        waitpid(writer, nullptr, 0);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        bool passed = outcome == c.expected && usage.ru_maxrss <= memoryLimit;
+        printf("%-4s %-14s %-14s %6ld KB  %s\n", passed ? "ok" : "FAIL", c.name,
+            scannerName, usage.ru_maxrss, outcome.c_str());
+        fflush(stdout);
+        _exit(passed ? 0 : 1);
+    }
+
+    int status;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    int failures = 0;
+    for (const Case &c : cases) {
+        failures += !run<Scanner<CharStream>>(c, "Scanner");
+        failures += !run<TableScanner>(c, "TableScanner");
+    }
+    if (failures)
+        printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Speed and accuracy of n-ary sums against the tree walk: long '+'/'-'
+// chains are evaluated by Interpreter as parsed, one dependent addition
+// after the other, and once flattened into a SumExpression, added by
+// pairwise summation. Errors are relative to a compensated sum in long
+// double of the same terms.
+//
+// Usage:
+//     SumBench [terms]
+
+#include "../Interpreter.h"
+#include "../Parser.h"
+#include "../SumFlattening.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <stdlib.h>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+// Neumaier's compensated sum, in long double.
+static long double referenceSum(const double *terms, size_t n)
+{
+    long double sum = 0, compensation = 0;
+    for (size_t i = 0; i < n; i++) {
+        long double t = sum + terms[i];
+        if (fabsl(sum) >= fabsl(terms[i]))
+            compensation += (sum - t) + terms[i];
+        else
+            compensation += (terms[i] - t) + sum;
+        sum = t;
+    }
+    return sum + compensation;
+}
+
+static void measure(const char *input, const std::string &text)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    AbstractNode *chain = parser.expression();
+
+    SentinelSource sumStream(text.c_str(), text.size());
+    TokenScanner sumScanner(&sumStream);
+    Parser<TokenScanner> sumParser(&sumScanner);
+    AbstractNode *sum = flattenSums(sumParser.expression(), sumParser.memoryResource());
+
+    // every term is a literal, so the sum holds them all
+    const SumExpression *terms = static_cast<const SumExpression *>(sum);
+    size_t n = terms->terms.size();
+    long double reference = referenceSum(terms->terms.data(), n);
+
+    Interpreter interpreter;
+    double chainValue = 0, sumValue = 0;
+    int runs = n < 100000 ? 1000 : 10;
+    double chainTime = bestOf(runs, [&] {
+        chainValue = interpreter.tryEvaluate(chain).value().toDouble();
+    });
+    double sumTime = bestOf(runs, [&] {
+        sumValue = interpreter.tryEvaluate(sum).value().toDouble();
+    });
+
+    printf("%-14s chain %6.2f ns/term, error %8.2e | n-ary sum %6.2f ns/term, error %8.2e\n",
+        input, chainTime * 1e9 / n, (double)fabsl((chainValue - reference) / reference),
+        sumTime * 1e9 / n, (double)fabsl((sumValue - reference) / reference));
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    for (size_t n = 1000; n <= terms; n *= 10) {
+        char name[32];
+        snprintf(name, sizeof(name), "sum %zu", n);
+        measure(name, randomExpression(n, "+"));
+        snprintf(name, sizeof(name), "+/- %zu", n);
+        measure(name, randomExpression(n, "+-"));
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of tokenizeAll() filling token columns against pulling the
+// same tokens one at a time from Scanner, in tokens per second, with a
+// bulk pass summing the numbers afterwards. The columns are checked
+// against the pulled tokens as well.
+//
+// Usage:
+//     TokenizeBench [terms]
+
+#include "../Scanner.h"
+#include "../TokenColumns.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+
+// Sum the numbers pulled from the scanner; return the token count.
+static size_t pull(const std::string &text, double *sum)
+{
+    SpanSource charStream(text.data(), text.size());
+    Scanner<SpanSource> scanner(&charStream);
+    size_t count = 0;
+    *sum = 0;
+    for (const Token *token = &scanner.currentToken(); token->type != EOF;
+         token = &scanner.nextToken(), ++count) {
+        if (token->type == Token::Number)
+            *sum += token->number();
+    }
+    return count;
+}
+
+// Sum the numbers of the columns, as a bulk consumer would.
+static double sumNumbers(const TokenColumns &columns)
+{
+    const uint8_t *type = columns.type.data();
+    const double *value = columns.value.data();
+    double sum = 0;
+    for (size_t i = 0; i < columns.size(); i++)
+        sum += type[i] == (uint8_t)Token::Number ? value[i] : 0;
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+    std::string text = randomExpression(terms, "+-*/", 16);
+
+    // the columns must hold what the scanner hands out
+    TokenColumns columns;
+    tokenizeAll(text.data(), text.size(), &columns);
+    SpanSource charStream(text.data(), text.size());
+    Scanner<SpanSource> scanner(&charStream);
+    size_t mismatches = 0;
+    size_t i = 0;
+    for (const Token *token = &scanner.currentToken(); token->type != EOF;
+         token = &scanner.nextToken(), ++i) {
+        mismatches += i >= columns.size() || columns.type[i] != (uint8_t)token->type
+            || columns.offset[i] != token->offset || columns.length[i] != token->length
+            || columns.value[i] != token->number();
+    }
+    mismatches += i != columns.size();
+    printf("%zu tokens, %zu mismatching\n", columns.size(), mismatches);
+
+    size_t count = 0;
+    double sum = 0;
+    double pulled = bestOf(5, [&] { count = pull(text, &sum); });
+    benchmarkSink = sum;
+    double filled = bestOf(5, [&] {
+        columns.clear();
+        count = tokenizeAll(text.data(), text.size(), &columns);
+    });
+    double summed = bestOf(5, [&] { benchmarkSink = sumNumbers(columns); });
+
+    printf("Scanner::nextToken  %8.1f Mtok/s (scan and sum)\n", count / pulled / 1e6);
+    printf("tokenizeAll         %8.1f Mtok/s (scan into columns)\n", count / filled / 1e6);
+    printf("sum over columns    %8.1f Mtok/s\n", count / summed / 1e6);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Offline decoder of the binary trace dumps written by Trace.
+//
+// Usage:
+//     TraceDecoder trace.bin
+
+#include "../Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DECL_TRACE_EVENT(name, format) #name,
+static const char *const names[] = { DECL_TRACE_EVENT_SET };
+#undef DECL_TRACE_EVENT
+
+#define DECL_TRACE_EVENT(name, format) format,
+static const char *const formats[] = { DECL_TRACE_EVENT_SET };
+#undef DECL_TRACE_EVENT
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "Usage: TraceDecoder trace.bin\n");
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        fprintf(stderr, "TraceDecoder: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, "ITRACE1", 8) != 0) {
+        fprintf(stderr, "TraceDecoder: %s is not a trace dump\n", argv[1]);
+        return 1;
+    }
+    if (header.dropped)
+        printf("(%llu older records dropped)\n", (unsigned long long)header.dropped);
+
+    TraceRecord r;
+    while (fread(&r, sizeof(r), 1, fp) == 1) {
+        printf("%12.3f us  ", r.time / 1000.0);
+        if (r.event < Trace::EventCount) {
+            printf("%-18s", names[r.event]);
+            printf(formats[r.event], (long long)r.arg0, (long long)r.arg1);
+        } else {
+            printf("event %llu: %llu, %llu", (unsigned long long)r.event,
+                (unsigned long long)r.arg0, (unsigned long long)r.arg1);
+        }
+        printf("\n");
+    }
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the validate-only path in GB/s: the structural indexer
+// alone (stage 1), the Validator built on it, and checking the same
+// lines with the scanner and parser for comparison.
+//
+// Usage:
+//     ValidatorBench [megabytes]
+
+#include "../Parser.h"
+#include "../StructuralIndexer.h"
+#include "Benchmark.h"
+#include <stdlib.h>
+#include <vector>
+
+static void measure(const char *input, const std::string &text)
+{
+    StructuralIndexer::Block block;
+    double stage1 = bestOf(5, [&] {
+        uint64_t digits = 0;
+        for (size_t base = 0; base + StructuralIndexer::BlockSize <= text.size();
+             base += StructuralIndexer::BlockSize) {
+            StructuralIndexer::classify(text.data() + base, &block);
+            digits += block.digit;
+        }
+        benchmarkSink = digits;
+    });
+
+    bool accepted = false;
+    double validate = bestOf(5, [&] {
+        Validator validator;
+        accepted = validator.validate(text.data(), text.size());
+    });
+
+    size_t errors = 0;
+    double check = bestOf(3, [&] {
+        SpanSource charStream(text.data(), text.size());
+        Scanner<SpanSource> scanner(&charStream);
+        Parser<Scanner<SpanSource>> parser(&scanner);
+        std::vector<Diagnostic> diagnostics;
+        parser.check(&diagnostics);
+        errors = diagnostics.size();
+    });
+
+    if (accepted != (errors == 0))
+        printf("%s: Validator and Parser::check disagree!\n", input);
+    printf("%-14s stage 1 %6.2f GB/s  Validator %6.2f GB/s  Parser::check %6.2f GB/s\n", input,
+        text.size() / stage1 / 1e9, text.size() / validate / 1e9, text.size() / check / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 64) << 20;
+
+    // a few terms a line, numbers of every form
+    std::string dense = randomExpression(size / 6, "+-*/", 8);
+
+    // the same lines indented and spaced out
+    std::string sparse;
+    std::string line;
+    for (char ch : randomExpression(size / 60, "+-", 4)) {
+        if (ch != '\n') {
+            line += ch;
+            if (ch == ' ')
+                line.append(16, ' ');
+            continue;
+        }
+        sparse += std::string(32, ' ') + line + "\n\n";
+        line.clear();
+    }
+
+    measure("token-dense", dense);
+    measure("blank-heavy", sparse);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Regression checks of the Validator against Parser::check: random
+// sources, valid or broken in every way the grammar allows, must be
+// accepted or rejected alike. (Error offsets differ: the Validator points
+// at the offending byte, Parser::check at the token holding it.)
+//
+// Usage:
+//     ValidatorCheck
+
+#include "../Parser.h"
+#include "../StructuralIndexer.h"
+#include <random>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool passed, const char *what)
+{
+    printf("%-4s %s\n", passed ? "ok" : "FAIL", what);
+    failures += !passed;
+}
+
+// Pieces sources are made of, most of them valid on their own.
+static const char *const pieces[] = { "1", "42", "0.5", "7.", ".25", "3e8", "2E-3",
+    "6e+02", "1.5e3", ".5e-1", "x", "y1", "_a", "e", "e5", "E", "+", "-", "*", "/",
+    "(", ")", " ", "  ", "\t", "\r", "\n", "\n\n", " + ", " - ", " * ", "-(", "1e",
+    "1e+", ".", "1..2", "1.2.3", "1e5e", "x.y", "1x", "#", "1e5.", "9e-" };
+
+// A source of count pieces; with valid set, an expression per line.
+static std::string randomSource(std::mt19937_64 &random, size_t count, bool valid)
+{
+    std::string text;
+    if (!valid) {
+        for (size_t i = 0; i < count; ++i)
+            text += pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+        return text;
+    }
+    static const char *const operands[] = { "1", "42", "0.5", "7.", ".25", "3e8", "2E-3",
+        "6e+02", "x", "y1", "_a", "e", "e5", "a1e", "x2E" };
+    static const char *const operators[] = { "+", "-", "*", "/", " + ", " -", "\t*\t" };
+    size_t depth = 0;
+    for (size_t i = 0; i < count; ++i) {
+        while (random() % 4 == 0) {
+            text += random() % 2 ? "-" : "(";
+            depth += text.back() == '(';
+        }
+        text += operands[random() % (sizeof(operands) / sizeof(operands[0]))];
+        while (depth && random() % 3 == 0) {
+            text += ")";
+            --depth;
+        }
+        if (random() % 8 == 0) {
+            text += std::string(depth, ')') + std::string(random() % 3, ' ') + "\n";
+            depth = 0;
+            if (random() % 4 == 0)
+                text += std::string(random() % 70, ' ') + "\n";
+        } else {
+            text += operators[random() % (sizeof(operators) / sizeof(operators[0]))];
+            text += std::string(random() % 3 ? 0 : random() % 70, ' ');
+        }
+    }
+    return text + "1" + std::string(depth, ')');
+}
+
+// Return true if the Validator agrees with Parser::check on text.
+static bool agree(const std::string &text)
+{
+    SpanSource charStream(text.data(), text.size());
+    Scanner<SpanSource> scanner(&charStream);
+    Parser<Scanner<SpanSource>> parser(&scanner);
+    std::vector<Diagnostic> diagnostics;
+    parser.check(&diagnostics);
+
+    Validator validator;
+    return validator.validate(text.data(), text.size()) == diagnostics.empty();
+}
+
+int main()
+{
+    std::mt19937_64 random(5);
+    size_t differ = 0;
+    for (int i = 0; i < 20000; ++i)
+        differ += !agree(randomSource(random, 1 + random() % 100, true));
+    check(differ == 0, "Validator accepts valid random sources");
+
+    differ = 0;
+    for (int i = 0; i < 100000; ++i)
+        differ += !agree(randomSource(random, 1 + random() % 40, false));
+    check(differ == 0, "Validator agrees with Parser::check on random pieces");
+
+    if (failures)
+        printf("%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+// Copyright (C) 2015-2016, kylinsage <kylinsage@gmail.com>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Benchmark of the bytecode VM against the tree-walking Interpreter on
+// long chains: time per node to evaluate an expression already parsed
+// (pointer tree, flat tree) or compiled (Program). The results are
+// compared as well.
+//
+// Usage:
+//     VmBench [terms]
+
+#include "../Bytecode.h"
+#include "../Interpreter.h"
+#include "../Parser.h"
+#include "Benchmark.h"
+#include <math.h>
+#include <stdlib.h>
+
+typedef Scanner<SentinelSource> TokenScanner;
+
+static void measure(const char *input, const std::string &text)
+{
+    SentinelSource charStream(text.c_str(), text.size());
+    TokenScanner scanner(&charStream);
+    Parser<TokenScanner> parser(&scanner);
+    AbstractNode *root = parser.expression();
+
+    SentinelSource flatStream(text.c_str(), text.size());
+    TokenScanner flatScanner(&flatStream);
+    Parser<TokenScanner> flatParser(&flatScanner);
+    FlatTree tree;
+    flatParser.expression(&tree);
+
+    Program program;
+    Compiler compiler(&program);
+    compiler.tryCompile(root);
+
+    Interpreter interpreter;
+    VirtualMachine machine;
+    double pointerValue = 0, flatValue = 0, vmValue = 0;
+    int runs = text.size() < 100000 ? 1000 : 10;
+    double pointerTime = bestOf(runs, [&] {
+        pointerValue = interpreter.tryEvaluate(root).value().toDouble();
+    });
+    double flatTime = bestOf(runs, [&] {
+        flatValue = interpreter.tryEvaluate(&tree).value().toDouble();
+    });
+    double vmTime = bestOf(runs, [&] { vmValue = machine.run(program); });
+
+    double nodes = tree.nodes.size();
+    bool same = fabs(pointerValue - vmValue) <= 1e-12 * fabs(pointerValue)
+        && flatValue == vmValue;
+    printf("%-12s %8zu nodes  Interpreter %6.2f  flat tree %6.2f  VM %6.2f ns/node%s\n",
+        input, tree.nodes.size(), pointerTime * 1e9 / nodes, flatTime * 1e9 / nodes,
+        vmTime * 1e9 / nodes, same ? "" : "  RESULTS DIFFER!");
+}
+
+int main(int argc, char **argv)
+{
+    size_t terms = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    for (size_t n = 1000; n <= terms; n *= 10) {
+        char name[32];
+        snprintf(name, sizeof(name), "sum %zu", n);
+        measure(name, randomExpression(n, "+-"));
+        snprintf(name, sizeof(name), "mixed %zu", n);
+        measure(name, randomExpression(n, "+-+-*/"));
+    }
+    return 0;
+}
@@ -31,6 +31,8 @@
   *
   * Compile:
   *     gcc parser.c
+  * or, to print every scanned token:
+  *     gcc -DTRACE parser.c
   * Run:
   *     ./a.out filename1 filename2 ...
   * or input from stdin (press Enter to input another line, and Ctrl+D to finish):
@@ -43,6 +45,13 @@
 #include "error.h"
 #include "exception.h"
 
+/* Token tracing, compiled in only with -DTRACE */
+#ifdef TRACE
+#define trace(...) printf(__VA_ARGS__)
+#else
+#define trace(...) ((void)0)
+#endif
+
 /***********************************************************
  * CharStream -- characters stream
  **********************************************************/
@@ -94,12 +103,14 @@ typedef enum {
 } TokenType;
 #undef DECL_TOKEN
 
+#ifdef TRACE
 #define DECL_TOKEN(type, text) text,
 static const char *TokenText[] = {
     DECL_TOKEN_SET
 };
 
 #undef DECL_TOKEN
+#endif
 //int None = 256, Integer = 257, Float = 258, Plus = 259, Minus = 260;
 
 struct Token {
@@ -269,10 +280,10 @@ struct Token scanner_next_token(struct Scanner *scanner)
         scanner_set_text(scanner, "EOS");
         scanner_set_type(scanner, EOS);
     }
-    printf(".. Scanning token: %s, position: (%d, %d), type: %s\n",
-           scanner->token.text,
-           scanner->token.row, scanner->token.column,
-           TokenText[scanner->token.type]);
+    trace(".. Scanning token: %s, position: (%d, %d), type: %s\n",
+          scanner->token.text,
+          scanner->token.row, scanner->token.column,
+          TokenText[scanner->token.type]);
     return scanner->token;
 }
 